@@ -0,0 +1,298 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+#include <utils/dynres.h>
+
+namespace {
+
+    using namespace openxr_api_layer::utils::dynres;
+
+    // 90 Hz.
+    constexpr double DisplayPeriodMs = 1000.0 / 90;
+
+    // A GPU-bound application: the frame time grows with the pixel count, ie: the square of the render scale, on top
+    // of a fixed cost.
+    struct Application {
+        double fixedMs{1.0};
+        double fullResolutionMs{10.0};
+
+        // An application that sized its swapchains once and keeps rendering at that scale, rather than following the
+        // recommended resolution. 0 when following.
+        float fixedScale{0.0f};
+
+        float getRenderedScale(float scale) const {
+            return fixedScale > 0.0f ? fixedScale : scale;
+        }
+
+        double getFrameTime(float scale) const {
+            const float renderedScale = getRenderedScale(scale);
+            return fixedMs + (fullResolutionMs - fixedMs) * renderedScale * renderedScale;
+        }
+    };
+
+    struct SimulationResult {
+        float finalScale{0.0f};
+        uint32_t scaleChanges{0};
+        // Changes in the opposite direction of the previous change.
+        uint32_t reversals{0};
+        uint32_t framesOverBudget{0};
+        bool alwaysQuantized{true};
+        bool alwaysInRange{true};
+    };
+
+    SimulationResult simulate(Controller& controller,
+                              const Application& application,
+                              uint32_t frameCount,
+                              const ControllerSettings& settings = {}) {
+        SimulationResult result;
+        float scale = controller.getScale();
+        float lastChange = 0.0f;
+        for (uint32_t i = 0; i < frameCount; i++) {
+            const double frameTimeMs = application.getFrameTime(scale);
+            if (frameTimeMs > DisplayPeriodMs) {
+                result.framesOverBudget++;
+            }
+            const float newScale =
+                controller.update(frameTimeMs, DisplayPeriodMs, application.getRenderedScale(scale));
+            if (newScale != scale) {
+                result.scaleChanges++;
+                if (lastChange * (newScale - scale) < 0.0f) {
+                    result.reversals++;
+                }
+                lastChange = newScale - scale;
+            }
+            scale = newScale;
+
+            const float steps = scale / settings.step;
+            result.alwaysQuantized = result.alwaysQuantized && std::abs(steps - std::round(steps)) < 1e-3f;
+            result.alwaysInRange = result.alwaysInRange && scale >= settings.minScale && scale <= settings.maxScale;
+        }
+        result.finalScale = scale;
+        return result;
+    }
+
+} // namespace
+
+TEST_CASE(DynRes_StartsAtMaximumScale) {
+    Controller controller;
+    CHECK_EQ(controller.getScale(), 1.0f);
+}
+
+TEST_CASE(DynRes_ResetClampsAndQuantizes) {
+    Controller controller;
+    controller.reset(0.77f);
+    CHECK(std::abs(controller.getScale() - 0.75f) < 1e-4f);
+    controller.reset(0.1f);
+    CHECK_EQ(controller.getScale(), 0.5f);
+    controller.reset(2.0f);
+    CHECK_EQ(controller.getScale(), 1.0f);
+}
+
+TEST_CASE(DynRes_InvalidTimingsAreIgnored) {
+    Controller controller;
+    controller.reset(0.75f);
+    for (int i = 0; i < 200; i++) {
+        controller.update(0.0, DisplayPeriodMs);
+        controller.update(50.0, 0.0);
+    }
+    CHECK(std::abs(controller.getScale() - 0.75f) < 1e-4f);
+    CHECK_EQ(controller.getUtilization(), 0.0f);
+}
+
+TEST_CASE(DynRes_LowersScaleUnderLoad) {
+    // 15ms at full resolution does not fit in 11.1ms.
+    Application application;
+    application.fullResolutionMs = 15.0;
+    Controller controller;
+    const SimulationResult result = simulate(controller, application, 900);
+
+    CHECK(result.alwaysQuantized);
+    CHECK(result.alwaysInRange);
+    CHECK(result.finalScale < 1.0f);
+    // Settled under the target utilization, with the scale one step up being over it.
+    CHECK(application.getFrameTime(result.finalScale) <= DisplayPeriodMs * 0.85 * 1.1);
+    CHECK(application.getFrameTime(result.finalScale + 0.05f) > DisplayPeriodMs * 0.85 * 0.9);
+    // Frames are only dropped while the controller reacts.
+    CHECK(result.framesOverBudget < 90);
+}
+
+TEST_CASE(DynRes_SettlesWithoutOscillating) {
+    // Whichever the load, including the ones putting the target utilization between two steps: the scale converges
+    // without ever going back and forth. Loads right at the target may take a while to settle, so only the direction
+    // of the changes is checked.
+    for (double fullResolutionMs = 8.0; fullResolutionMs <= 30.0; fullResolutionMs += 0.5) {
+        Application application;
+        application.fullResolutionMs = fullResolutionMs;
+        Controller controller;
+        const SimulationResult result = simulate(controller, application, 3600);
+        CHECK_EQ(result.reversals, 0u);
+    }
+
+    // A load away from the boundaries stays put once settled.
+    Application application;
+    application.fullResolutionMs = 15.0;
+    Controller controller;
+    simulate(controller, application, 900);
+    const float settledScale = controller.getScale();
+    const SimulationResult settled = simulate(controller, application, 1800);
+    CHECK_EQ(settled.scaleChanges, 0u);
+    CHECK_EQ(settled.finalScale, settledScale);
+}
+
+TEST_CASE(DynRes_SaturatesAtMinimumScale) {
+    // Too heavy even at the minimum scale.
+    Application application;
+    application.fullResolutionMs = 60.0;
+    Controller controller;
+    const SimulationResult result = simulate(controller, application, 900);
+    CHECK_EQ(result.finalScale, 0.5f);
+    CHECK(result.alwaysInRange);
+}
+
+TEST_CASE(DynRes_RecoversWhenLoadDrops) {
+    Application heavy;
+    heavy.fullResolutionMs = 60.0;
+    Controller controller;
+    simulate(controller, heavy, 1800);
+    CHECK_EQ(controller.getScale(), 0.5f);
+
+    // The incremental controller does not wind up while saturated: it heads back up as soon as there is headroom,
+    // one step per hold period.
+    Application light;
+    light.fullResolutionMs = 5.0;
+    const ControllerSettings settings;
+    const uint32_t steps = (uint32_t)std::lround((settings.maxScale - settings.minScale) / settings.step);
+    const SimulationResult result = simulate(controller, light, (steps + 2) * settings.holdFramesUp);
+    CHECK_EQ(result.finalScale, 1.0f);
+}
+
+TEST_CASE(DynRes_RaisesSlowerThanItLowers) {
+    Application heavy;
+    heavy.fullResolutionMs = 20.0;
+    Application light;
+    light.fullResolutionMs = 5.0;
+    const ControllerSettings settings;
+
+    // Going down: the first step is taken within the short hold period.
+    Controller down;
+    const SimulationResult lowered = simulate(down, heavy, settings.holdFramesDown + 5);
+    CHECK(lowered.finalScale < 1.0f);
+
+    // Going up: nothing happens before the long hold period.
+    Controller up;
+    up.reset(0.5f);
+    const SimulationResult raised = simulate(up, light, settings.holdFramesUp - 1);
+    CHECK_EQ(raised.finalScale, 0.5f);
+    simulate(up, light, 2);
+    CHECK(up.getScale() > 0.5f);
+}
+
+TEST_CASE(DynRes_FollowsRecordedTrace) {
+    // A replayed trace: a loading spike, then steady gameplay. Only the order of magnitude of the time spent over
+    // budget is checked, since it depends on the gains.
+    Application application;
+    application.fullResolutionMs = 9.0;
+    Controller controller;
+    uint32_t framesOverBudget = 0;
+    float scale = controller.getScale();
+    for (uint32_t i = 0; i < 1200; i++) {
+        double frameTimeMs = application.getFrameTime(scale);
+        if (i >= 300 && i < 330) {
+            frameTimeMs *= 2.5;
+        }
+        if (frameTimeMs > DisplayPeriodMs) {
+            framesOverBudget++;
+        }
+        scale = controller.update(frameTimeMs, DisplayPeriodMs);
+    }
+    CHECK(framesOverBudget < 60);
+    // 9ms fits at full resolution with the default target: the controller returns there once the spike is over.
+    CHECK_EQ(scale, 1.0f);
+}
+
+TEST_CASE(DynRes_HoldsFixedRenderSize) {
+    // Too heavy at the scale the application renders at, but lowering the scale has no effect on it: the controller
+    // gives up after a few attempts and settles on the scale the application renders at, instead of running down to
+    // the minimum scale.
+    Application application;
+    application.fullResolutionMs = 20.0;
+    application.fixedScale = 0.8f;
+    Controller controller;
+    controller.reset(0.8f);
+    const SimulationResult result = simulate(controller, application, 1800);
+    CHECK(!controller.isFollowed());
+    CHECK(std::abs(result.finalScale - 0.8f) < 1e-4f);
+    CHECK(result.alwaysQuantized);
+
+    // Once settled, the recommended resolution does not change anymore.
+    const SimulationResult settled = simulate(controller, application, 1800);
+    CHECK_EQ(settled.scaleChanges, 0u);
+
+    // A fixed size at full resolution is held as well.
+    Application native;
+    native.fullResolutionMs = 20.0;
+    native.fixedScale = 1.0f;
+    Controller nativeController;
+    simulate(nativeController, native, 1800);
+    CHECK(!nativeController.isFollowed());
+    CHECK_EQ(nativeController.getScale(), 1.0f);
+}
+
+TEST_CASE(DynRes_ResumesWhenResolutionChanges) {
+    Application application;
+    application.fullResolutionMs = 15.0;
+    application.fixedScale = 1.0f;
+    Controller controller;
+    simulate(controller, application, 900);
+    CHECK(!controller.isFollowed());
+
+    // The application queried the recommended resolution again, and now follows it.
+    application.fixedScale = 0.0f;
+    controller.update(application.getFrameTime(0.9f), DisplayPeriodMs, 0.9f);
+    CHECK(controller.isFollowed());
+    const SimulationResult result = simulate(controller, application, 1800);
+    CHECK(controller.isFollowed());
+    CHECK(result.finalScale < 1.0f);
+    CHECK(application.getFrameTime(result.finalScale) <= DisplayPeriodMs * 0.85 * 1.1);
+}
+
+TEST_CASE(DynRes_FollowingApplicationMayLag) {
+    // The application picks up the new recommended resolution a few frames late: it still follows.
+    Application application;
+    application.fullResolutionMs = 15.0;
+    Controller controller;
+    std::deque<float> pending(3, controller.getScale());
+    for (uint32_t i = 0; i < 900; i++) {
+        const float renderedScale = pending.front();
+        pending.pop_front();
+        pending.push_back(controller.update(application.getFrameTime(renderedScale), DisplayPeriodMs, renderedScale));
+        CHECK(controller.isFollowed());
+    }
+    CHECK(controller.getScale() < 1.0f);
+}
@@ -0,0 +1,158 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+#include <utils/formats.h>
+
+namespace {
+
+    using namespace openxr_api_layer::utils::formats;
+
+    struct ExpectedFormat {
+        DXGI_FORMAT format;
+        DXGI_FORMAT resourceFormat;
+        DXGI_FORMAT srvFormat;
+        DXGI_FORMAT uavFormat;
+        DXGI_FORMAT packedUavFormat;
+        StoreMode packedStoreMode;
+        bool isSRGB;
+    };
+
+    // clang-format off
+    const ExpectedFormat ExpectedFormats[] = {
+        {DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UINT,    StoreMode::PackedUnorm8,  false},
+        {DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UINT,    StoreMode::PackedUnorm8,  true},
+        {DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UINT,    StoreMode::PackedUnorm8,  false},
+        {DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         true},
+        {DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         true},
+        {DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_R10G10B10A2_UNORM,    DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UINT, StoreMode::PackedUnorm10, false},
+        {DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UINT, StoreMode::PackedUnorm10, false},
+        {DXGI_FORMAT_R11G11B10_FLOAT,      DXGI_FORMAT_R11G11B10_FLOAT,      DXGI_FORMAT_R11G11B10_FLOAT,    DXGI_FORMAT_R11G11B10_FLOAT,    DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_R16G16B16A16_FLOAT,   DXGI_FORMAT_R16G16B16A16_FLOAT,   DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+    };
+    // clang-format on
+
+    bool isTypedStoreAlwaysSupported(DXGI_FORMAT) {
+        return true;
+    }
+
+    bool isTypedStoreNeverSupported(DXGI_FORMAT) {
+        return false;
+    }
+
+    // A device that only supports typed stores to UINT views.
+    bool isTypedStoreSupportedForUint(DXGI_FORMAT format) {
+        return format == DXGI_FORMAT_R8G8B8A8_UINT || format == DXGI_FORMAT_R10G10B10A2_UINT;
+    }
+
+} // namespace
+
+TEST_CASE(Formats_TableMatchesExpectedMappings) {
+    for (const auto& expected : ExpectedFormats) {
+        const FormatInfo* info = getFormatInfo(expected.format);
+        CHECK(info != nullptr);
+        if (!info) {
+            continue;
+        }
+        CHECK_EQ(info->format, expected.format);
+        CHECK_EQ(info->resourceFormat, expected.resourceFormat);
+        CHECK_EQ(info->srvFormat, expected.srvFormat);
+        CHECK_EQ(info->uavFormat, expected.uavFormat);
+        CHECK_EQ(info->packedUavFormat, expected.packedUavFormat);
+        CHECK(info->packedStoreMode == expected.packedStoreMode);
+        CHECK_EQ(info->isSRGB, expected.isSRGB);
+    }
+}
+
+TEST_CASE(Formats_UnsupportedFormatsAreRejected) {
+    CHECK(getFormatInfo(DXGI_FORMAT_UNKNOWN) == nullptr);
+    CHECK(getFormatInfo(DXGI_FORMAT_R32G32B32A32_FLOAT) == nullptr);
+    // UINT formats are only ever used as views.
+    CHECK(getFormatInfo(DXGI_FORMAT_R8G8B8A8_UINT) == nullptr);
+    CHECK(getFormatInfo(DXGI_FORMAT_R10G10B10A2_UINT) == nullptr);
+}
+
+TEST_CASE(Formats_ViewsNeverUseSRGB) {
+    // UAVs cannot be sRGB, and the shaders decode sRGB themselves so that reads and writes are symmetrical.
+    for (const auto& expected : ExpectedFormats) {
+        const FormatInfo* info = getFormatInfo(expected.format);
+        if (!info) {
+            continue;
+        }
+        CHECK(info->srvFormat != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
+        CHECK(info->srvFormat != DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+        CHECK(info->srvFormat != DXGI_FORMAT_B8G8R8X8_UNORM_SRGB);
+        CHECK_EQ(info->srvFormat, info->uavFormat);
+    }
+}
+
+TEST_CASE(Formats_PackedFallbackHasAStoreMode) {
+    for (const auto& expected : ExpectedFormats) {
+        const FormatInfo* info = getFormatInfo(expected.format);
+        if (!info) {
+            continue;
+        }
+        CHECK_EQ(info->packedUavFormat == DXGI_FORMAT_UNKNOWN, info->packedStoreMode == StoreMode::Typed);
+    }
+}
+
+TEST_CASE(Formats_StorePlanPrefersTypedStores) {
+    for (const auto& expected : ExpectedFormats) {
+        const auto plan = chooseStorePlan(*getFormatInfo(expected.format), isTypedStoreAlwaysSupported);
+        CHECK(plan.has_value());
+        if (plan) {
+            CHECK_EQ(plan->uavFormat, expected.uavFormat);
+            CHECK(plan->storeMode == StoreMode::Typed);
+        }
+    }
+}
+
+TEST_CASE(Formats_StorePlanFallsBackToPackedStores) {
+    for (const auto& expected : ExpectedFormats) {
+        const auto plan = chooseStorePlan(*getFormatInfo(expected.format), isTypedStoreSupportedForUint);
+        if (expected.packedUavFormat == DXGI_FORMAT_UNKNOWN) {
+            CHECK(!plan.has_value());
+        } else {
+            CHECK(plan.has_value());
+            if (plan) {
+                CHECK_EQ(plan->uavFormat, expected.packedUavFormat);
+                CHECK(plan->storeMode == expected.packedStoreMode);
+            }
+        }
+    }
+}
+
+TEST_CASE(Formats_StorePlanFailsWithoutAnyStore) {
+    for (const auto& expected : ExpectedFormats) {
+        CHECK(!chooseStorePlan(*getFormatInfo(expected.format), isTypedStoreNeverSupported).has_value());
+    }
+}
@@ -0,0 +1,171 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+#include <utils/frameplan.h>
+
+namespace {
+
+    using namespace openxr_api_layer::utils::frameplan;
+
+    Rect makeRect(int32_t x, int32_t y, int32_t width, int32_t height) {
+        Rect rect;
+        rect.x = x;
+        rect.y = y;
+        rect.width = width;
+        rect.height = height;
+        return rect;
+    }
+
+    WorkItem makeItem(uint64_t swapchain, uint32_t imageIndex, uint32_t arraySlice, const Rect& rect) {
+        WorkItem item;
+        item.swapchain = swapchain;
+        item.imageIndex = imageIndex;
+        item.arraySlice = arraySlice;
+        item.rect = rect;
+        return item;
+    }
+
+    bool sameRect(const Rect& a, const Rect& b) {
+        return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+    }
+
+} // namespace
+
+TEST_CASE(FramePlan_OverlapsIgnoresTouchingEdges) {
+    // Side-by-side stereo halves share an edge but no pixel.
+    CHECK(!overlaps(makeRect(0, 0, 100, 100), makeRect(100, 0, 100, 100)));
+    CHECK(!overlaps(makeRect(0, 0, 100, 100), makeRect(0, 100, 100, 100)));
+    CHECK(overlaps(makeRect(0, 0, 100, 100), makeRect(99, 99, 100, 100)));
+    CHECK(overlaps(makeRect(0, 0, 100, 100), makeRect(10, 10, 10, 10)));
+    CHECK(overlaps(makeRect(10, 10, 10, 10), makeRect(0, 0, 100, 100)));
+}
+
+TEST_CASE(FramePlan_OverlapsIgnoresEmptyRects) {
+    CHECK(!overlaps(makeRect(10, 10, 0, 10), makeRect(0, 0, 100, 100)));
+    CHECK(!overlaps(makeRect(0, 0, 100, 100), makeRect(10, 10, 10, -5)));
+}
+
+TEST_CASE(FramePlan_MergeIsBoundingBox) {
+    CHECK(sameRect(merge(makeRect(0, 0, 10, 10), makeRect(5, 20, 10, 10)), makeRect(0, 0, 15, 30)));
+    CHECK(sameRect(merge(makeRect(-5, 3, 10, 10), makeRect(0, 0, 2, 2)), makeRect(-5, 0, 10, 13)));
+}
+
+TEST_CASE(FramePlan_DisjointViewsAreKept) {
+    // One side-by-side swapchain with one rectangle per eye: nothing to merge.
+    FramePlanner planner;
+    planner.add(makeItem(1, 0, 0, makeRect(1000, 0, 1000, 1000)));
+    planner.add(makeItem(1, 0, 0, makeRect(0, 0, 1000, 1000)));
+    const auto& items = planner.build();
+
+    CHECK_EQ(items.size(), 2u);
+    CHECK_EQ(planner.getSubmittedCount(), 2u);
+    if (items.size() == 2) {
+        // Ordered left to right within the group.
+        CHECK(sameRect(items[0].rect, makeRect(0, 0, 1000, 1000)));
+        CHECK(sameRect(items[1].rect, makeRect(1000, 0, 1000, 1000)));
+    }
+}
+
+TEST_CASE(FramePlan_IdenticalItemsCollapse) {
+    // Eg: the same projection views submitted by two composition layers.
+    FramePlanner planner;
+    for (int i = 0; i < 3; i++) {
+        planner.add(makeItem(7, 2, 1, makeRect(0, 0, 512, 512)));
+    }
+    const auto& items = planner.build();
+
+    CHECK_EQ(items.size(), 1u);
+    CHECK_EQ(planner.getSubmittedCount(), 3u);
+    if (items.size() == 1) {
+        CHECK_EQ(items[0].swapchain, 7u);
+        CHECK_EQ(items[0].imageIndex, 2u);
+        CHECK_EQ(items[0].arraySlice, 1u);
+        CHECK(sameRect(items[0].rect, makeRect(0, 0, 512, 512)));
+    }
+}
+
+TEST_CASE(FramePlan_MergeIsTransitive) {
+    // A and C are disjoint, but the merge of A and B grows to cover C.
+    FramePlanner planner;
+    planner.add(makeItem(1, 0, 0, makeRect(0, 0, 10, 10)));
+    planner.add(makeItem(1, 0, 0, makeRect(5, 5, 10, 10)));
+    planner.add(makeItem(1, 0, 0, makeRect(12, 0, 2, 2)));
+    const auto& items = planner.build();
+
+    CHECK_EQ(items.size(), 1u);
+    if (items.size() == 1) {
+        CHECK(sameRect(items[0].rect, makeRect(0, 0, 15, 15)));
+    }
+}
+
+TEST_CASE(FramePlan_GroupsAreNotMergedAcrossTargets) {
+    // Same rectangle, but each item targets a different swapchain, image or array slice.
+    const Rect rect = makeRect(0, 0, 100, 100);
+    FramePlanner planner;
+    planner.add(makeItem(2, 0, 0, rect));
+    planner.add(makeItem(1, 1, 0, rect));
+    planner.add(makeItem(1, 0, 1, rect));
+    planner.add(makeItem(1, 0, 0, rect));
+    const auto& items = planner.build();
+
+    CHECK_EQ(items.size(), 4u);
+    if (items.size() == 4) {
+        CHECK(items[0].swapchain == 1 && items[0].imageIndex == 0 && items[0].arraySlice == 0);
+        CHECK(items[1].swapchain == 1 && items[1].imageIndex == 0 && items[1].arraySlice == 1);
+        CHECK(items[2].swapchain == 1 && items[2].imageIndex == 1 && items[2].arraySlice == 0);
+        CHECK(items[3].swapchain == 2 && items[3].imageIndex == 0 && items[3].arraySlice == 0);
+    }
+}
+
+TEST_CASE(FramePlan_EmptyRectsAreCountedButDropped) {
+    FramePlanner planner;
+    planner.add(makeItem(1, 0, 0, makeRect(0, 0, 0, 100)));
+    planner.add(makeItem(1, 0, 0, makeRect(0, 0, 100, 100)));
+    const auto& items = planner.build();
+
+    CHECK_EQ(items.size(), 1u);
+    CHECK_EQ(planner.getSubmittedCount(), 2u);
+}
+
+TEST_CASE(FramePlan_ResetStartsANewFrame) {
+    FramePlanner planner;
+    planner.add(makeItem(1, 0, 0, makeRect(0, 0, 100, 100)));
+    planner.build();
+
+    planner.reset();
+    CHECK_EQ(planner.getSubmittedCount(), 0u);
+    CHECK(planner.build().empty());
+
+    planner.add(makeItem(3, 0, 0, makeRect(0, 0, 10, 10)));
+    const auto& items = planner.build();
+    CHECK_EQ(items.size(), 1u);
+    if (items.size() == 1) {
+        CHECK_EQ(items[0].swapchain, 3u);
+    }
+}
@@ -0,0 +1,79 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+namespace openxr_api_layer::log {
+    // The layer sources log through this stream. It stays closed, so the tests only log to the debugger.
+    std::ofstream logStream;
+} // namespace openxr_api_layer::log
+
+namespace openxr_api_layer::tests {
+
+    namespace {
+        uint32_t g_failureCount = 0;
+    } // namespace
+
+    std::vector<TestCase>& getTestCases() {
+        static std::vector<TestCase> testCases;
+        return testCases;
+    }
+
+    void reportFailure(const char* file, int line, const char* expression) {
+        std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+        g_failureCount++;
+    }
+
+} // namespace openxr_api_layer::tests
+
+int main(int argc, char** argv) {
+    using namespace openxr_api_layer::tests;
+
+    // An optional argument restricts the run to the tests whose name contains it.
+    const std::string filter = argc > 1 ? argv[1] : "";
+
+    uint32_t failedTests = 0;
+    uint32_t ranTests = 0;
+    for (const auto& testCase : getTestCases()) {
+        if (!filter.empty() && std::string(testCase.name).find(filter) == std::string::npos) {
+            continue;
+        }
+
+        const uint32_t failuresBefore = g_failureCount;
+        testCase.function();
+        ranTests++;
+        if (g_failureCount != failuresBefore) {
+            std::printf("[FAILED] %s\n", testCase.name);
+            failedTests++;
+        } else {
+            std::printf("[  OK  ] %s\n", testCase.name);
+        }
+    }
+
+    std::printf("%u/%u tests passed\n", ranTests - failedTests, ranTests);
+    return failedTests ? 1 : 0;
+}
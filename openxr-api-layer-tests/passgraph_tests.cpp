@@ -0,0 +1,262 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+#include <utils/passgraph.h>
+
+namespace {
+
+    using namespace openxr_api_layer::utils::passgraph;
+
+    enum Tag : uint32_t { CopyIn = 0, Sharpen, Tonemap, Levels, CopyOut };
+
+    Texture pooled(uint32_t sizeClass, uint32_t index) {
+        Texture texture;
+        texture.sizeClass = sizeClass;
+        texture.index = index;
+        return texture;
+    }
+
+    std::vector<uint32_t> getTags(const PassGraph& graph) {
+        std::vector<uint32_t> tags;
+        for (const auto& step : graph.getSteps()) {
+            tags.push_back(step.tag);
+        }
+        return tags;
+    }
+
+    bool hasBarrier(const PassGraph& graph, const Step& step, const Texture& texture, Access before, Access after) {
+        const auto& barriers = graph.getBarriers();
+        for (uint32_t i = step.firstBarrier; i < step.firstBarrier + step.barrierCount; i++) {
+            if (barriers[i].texture == texture && barriers[i].before == before && barriers[i].after == after) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The chain of the layer: copy in, compute passes, copy out, all in size class 0.
+    void buildChain(PassGraph& graph, const std::vector<std::pair<uint32_t, bool>>& computePasses) {
+        graph.reset();
+        const ResourceId source = graph.importTexture();
+        const ResourceId destination = graph.importTexture();
+        ResourceId current = graph.createTransient(0);
+        graph.addPass(CopyIn, PassKind::Copy, source, current);
+        for (const auto& [tag, enabled] : computePasses) {
+            const ResourceId next = graph.createTransient(0);
+            graph.addPass(tag, PassKind::Compute, current, next, enabled);
+            current = next;
+        }
+        graph.addPass(CopyOut, PassKind::Copy, current, destination);
+    }
+
+} // namespace
+
+TEST_CASE(PassGraph_ChainPingPongsBetweenTwoTextures) {
+    PassGraph graph;
+    buildChain(graph, {{Sharpen, true}, {Sharpen, true}, {Tonemap, true}, {Levels, true}});
+    CHECK(graph.compile());
+
+    CHECK(getTags(graph) == std::vector<uint32_t>({CopyIn, Sharpen, Sharpen, Tonemap, Levels, CopyOut}));
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(2));
+    for (const auto& step : graph.getSteps()) {
+        CHECK(!(step.input == step.output));
+    }
+
+    // Each result is read by the next step.
+    const auto& steps = graph.getSteps();
+    for (size_t i = 1; i < steps.size(); i++) {
+        CHECK(steps[i].input == steps[i - 1].output);
+    }
+    CHECK(steps.front().input.isImported() && steps.front().input.index == 0);
+    CHECK(steps.back().output.isImported() && steps.back().output.index == 1);
+}
+
+TEST_CASE(PassGraph_SinglePassNeedsOneTexturePerSide) {
+    PassGraph graph;
+    buildChain(graph, {{Sharpen, true}});
+    CHECK(graph.compile());
+
+    const auto& steps = graph.getSteps();
+    CHECK_EQ(steps.size(), size_t(3));
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(2));
+    if (steps.size() == 3) {
+        CHECK(steps[0].output == pooled(0, 0));
+        CHECK(steps[1].input == pooled(0, 0));
+        CHECK(steps[1].output == pooled(0, 1));
+        CHECK(steps[2].input == pooled(0, 1));
+    }
+}
+
+TEST_CASE(PassGraph_DisabledPassesAreBypassed) {
+    PassGraph graph;
+    buildChain(graph, {{Sharpen, true}, {Tonemap, false}, {Levels, true}});
+    CHECK(graph.compile());
+
+    CHECK(getTags(graph) == std::vector<uint32_t>({CopyIn, Sharpen, Levels, CopyOut}));
+    const auto& steps = graph.getSteps();
+    if (steps.size() == 4) {
+        // Levels reads the output of Sharpen, as if Tonemap was not there.
+        CHECK(steps[2].input == steps[1].output);
+    }
+}
+
+TEST_CASE(PassGraph_DisabledLastPassForwardsToCopyOut) {
+    PassGraph graph;
+    buildChain(graph, {{Sharpen, true}, {Tonemap, false}, {Levels, false}});
+    CHECK(graph.compile());
+
+    CHECK(getTags(graph) == std::vector<uint32_t>({CopyIn, Sharpen, CopyOut}));
+    const auto& steps = graph.getSteps();
+    if (steps.size() == 3) {
+        CHECK(steps[2].input == steps[1].output);
+    }
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(2));
+}
+
+TEST_CASE(PassGraph_AllPassesDisabledCopiesStraightThrough) {
+    PassGraph graph;
+    buildChain(graph, {{Sharpen, false}, {Levels, false}});
+    CHECK(graph.compile());
+
+    CHECK(getTags(graph) == std::vector<uint32_t>({CopyIn, CopyOut}));
+    const auto& steps = graph.getSteps();
+    if (steps.size() == 2) {
+        CHECK(steps[1].input == steps[0].output);
+    }
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(1));
+}
+
+TEST_CASE(PassGraph_UnreadResultsAreCulled) {
+    PassGraph graph;
+    const ResourceId source = graph.importTexture();
+    const ResourceId destination = graph.importTexture();
+    const ResourceId copy = graph.createTransient(0);
+    const ResourceId unused = graph.createTransient(0);
+    const ResourceId result = graph.createTransient(0);
+    graph.addPass(CopyIn, PassKind::Copy, source, copy);
+    graph.addPass(Tonemap, PassKind::Compute, copy, unused);
+    graph.addPass(Sharpen, PassKind::Compute, copy, result);
+    graph.addPass(CopyOut, PassKind::Copy, result, destination);
+    CHECK(graph.compile());
+
+    CHECK(getTags(graph) == std::vector<uint32_t>({CopyIn, Sharpen, CopyOut}));
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(2));
+}
+
+TEST_CASE(PassGraph_SizeClassesHaveTheirOwnTextures) {
+    PassGraph graph;
+    const ResourceId source = graph.importTexture();
+    const ResourceId destination = graph.importTexture();
+    const ResourceId copy = graph.createTransient(0);
+    const ResourceId scaled = graph.createTransient(1);
+    const ResourceId sharpened = graph.createTransient(1);
+    graph.addPass(CopyIn, PassKind::Copy, source, copy);
+    graph.addPass(Sharpen, PassKind::Compute, copy, scaled);
+    graph.addPass(Levels, PassKind::Compute, scaled, sharpened);
+    graph.addPass(CopyOut, PassKind::Copy, sharpened, destination);
+    CHECK(graph.compile());
+
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(1));
+    CHECK_EQ(graph.getTextureCount(1), uint32_t(2));
+    CHECK_EQ(graph.getTextureCount(2), uint32_t(0));
+    const auto& steps = graph.getSteps();
+    if (steps.size() == 4) {
+        CHECK(steps[1].output == pooled(1, 0));
+        CHECK(steps[2].output == pooled(1, 1));
+    }
+}
+
+TEST_CASE(PassGraph_BarriersFollowTheAccesses) {
+    PassGraph graph;
+    buildChain(graph, {{Sharpen, true}, {Levels, true}});
+    CHECK(graph.compile());
+
+    const auto& steps = graph.getSteps();
+    CHECK_EQ(steps.size(), size_t(4));
+    if (steps.size() != 4) {
+        return;
+    }
+    Texture source;
+    source.index = 0;
+    Texture destination;
+    destination.index = 1;
+    const Texture first = pooled(0, 0);
+    const Texture second = pooled(0, 1);
+
+    CHECK_EQ(steps[0].barrierCount, uint32_t(2));
+    CHECK(hasBarrier(graph, steps[0], source, Access::None, Access::CopySource));
+    CHECK(hasBarrier(graph, steps[0], first, Access::None, Access::CopyDest));
+
+    CHECK_EQ(steps[1].barrierCount, uint32_t(2));
+    CHECK(hasBarrier(graph, steps[1], first, Access::CopyDest, Access::ShaderRead));
+    CHECK(hasBarrier(graph, steps[1], second, Access::None, Access::ShaderWrite));
+
+    // The second pass writes where the copy in wrote, since the first pass was its last reader.
+    CHECK_EQ(steps[2].barrierCount, uint32_t(2));
+    CHECK(hasBarrier(graph, steps[2], second, Access::ShaderWrite, Access::ShaderRead));
+    CHECK(hasBarrier(graph, steps[2], first, Access::ShaderRead, Access::ShaderWrite));
+
+    CHECK_EQ(steps[3].barrierCount, uint32_t(2));
+    CHECK(hasBarrier(graph, steps[3], first, Access::ShaderWrite, Access::CopySource));
+    CHECK(hasBarrier(graph, steps[3], destination, Access::None, Access::CopyDest));
+}
+
+TEST_CASE(PassGraph_InvalidGraphsFailToCompile) {
+    PassGraph graph;
+    {
+        const ResourceId source = graph.importTexture();
+        const ResourceId unwritten = graph.createTransient(0);
+        const ResourceId result = graph.createTransient(0);
+        graph.addPass(CopyIn, PassKind::Copy, source, result);
+        graph.addPass(Sharpen, PassKind::Compute, unwritten, result);
+        CHECK(!graph.compile());
+    }
+
+    graph.reset();
+    {
+        const ResourceId source = graph.importTexture();
+        const ResourceId result = graph.createTransient(0);
+        graph.addPass(CopyIn, PassKind::Copy, source, result);
+        graph.addPass(Sharpen, PassKind::Compute, source, result);
+        CHECK(!graph.compile());
+    }
+}
+
+TEST_CASE(PassGraph_RecompilesAfterReset) {
+    PassGraph graph;
+    buildChain(graph, {{Sharpen, true}, {Sharpen, true}, {Sharpen, true}});
+    CHECK(graph.compile());
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(2));
+
+    // A shorter chain reuses the storage of the previous one, without keeping any of its state.
+    buildChain(graph, {{Sharpen, false}});
+    CHECK(graph.compile());
+    CHECK(getTags(graph) == std::vector<uint32_t>({CopyIn, CopyOut}));
+    CHECK_EQ(graph.getTextureCount(0), uint32_t(1));
+}
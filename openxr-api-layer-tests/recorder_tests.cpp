@@ -0,0 +1,231 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+#include <utils/recorder.h>
+
+namespace {
+
+    using namespace openxr_api_layer::utils::recorder;
+
+    // One call forwarded to the API.
+    struct Call {
+        enum class Type { Shader, ConstantBuffers, ShaderResources, UnorderedAccessViews, Dispatch };
+
+        Type type;
+        uint32_t startSlot;
+        std::vector<Handle> handles;
+    };
+
+    struct MockBindings : IComputeBindings {
+        explicit MockBindings(std::vector<Call>& calls) : calls(calls) {
+        }
+
+        void setShader(Handle shader) override {
+            calls.push_back({Call::Type::Shader, 0, {shader}});
+        }
+        void setConstantBuffers(uint32_t startSlot, uint32_t count, const Handle* buffers) override {
+            calls.push_back({Call::Type::ConstantBuffers, startSlot, {buffers, buffers + count}});
+        }
+        void setShaderResources(uint32_t startSlot, uint32_t count, const Handle* views) override {
+            calls.push_back({Call::Type::ShaderResources, startSlot, {views, views + count}});
+        }
+        void setUnorderedAccessViews(uint32_t startSlot, uint32_t count, const Handle* views) override {
+            calls.push_back({Call::Type::UnorderedAccessViews, startSlot, {views, views + count}});
+        }
+        void dispatch(uint32_t x, uint32_t y, uint32_t z) override {
+            calls.push_back({Call::Type::Dispatch, 0, {}});
+        }
+
+        std::vector<Call>& calls;
+    };
+
+    Handle handle(uintptr_t value) {
+        return reinterpret_cast<Handle>(value);
+    }
+
+    size_t countCalls(const std::vector<Call>& calls, Call::Type type) {
+        return std::count_if(calls.cbegin(), calls.cend(), [&](const Call& call) { return call.type == type; });
+    }
+
+    // The views of the last call of the given type, or an empty list.
+    std::vector<Handle> lastViews(const std::vector<Call>& calls, Call::Type type) {
+        const auto it =
+            std::find_if(calls.crbegin(), calls.crend(), [&](const Call& call) { return call.type == type; });
+        return it != calls.crend() ? it->handles : std::vector<Handle>{};
+    }
+
+} // namespace
+
+TEST_CASE(Recorder_FirstBindingsAreIssued) {
+    std::vector<Call> calls;
+    StateRecorder recorder(std::make_unique<MockBindings>(calls));
+
+    // A fresh recorder does not know what the application left bound, even null.
+    recorder.setShader(nullptr);
+    const Handle buffers[] = {nullptr};
+    recorder.setConstantBuffers(0, 1, buffers);
+
+    CHECK_EQ(calls.size(), size_t(2));
+    CHECK_EQ(recorder.getStats().requested, uint64_t(2));
+    CHECK_EQ(recorder.getStats().issued, uint64_t(2));
+}
+
+TEST_CASE(Recorder_RedundantBindingsAreElided) {
+    std::vector<Call> calls;
+    StateRecorder recorder(std::make_unique<MockBindings>(calls));
+
+    const Handle buffers[] = {handle(10), handle(11)};
+    for (int i = 0; i < 3; i++) {
+        recorder.setShader(handle(1));
+        recorder.setConstantBuffers(0, 2, buffers);
+    }
+
+    CHECK_EQ(countCalls(calls, Call::Type::Shader), size_t(1));
+    CHECK_EQ(countCalls(calls, Call::Type::ConstantBuffers), size_t(1));
+    CHECK_EQ(recorder.getStats().requested, uint64_t(6));
+    CHECK_EQ(recorder.getStats().issued, uint64_t(2));
+    CHECK_EQ(recorder.getStats().elided(), uint64_t(4));
+
+    recorder.resetStats();
+    CHECK_EQ(recorder.getStats().requested, uint64_t(0));
+    CHECK_EQ(recorder.getStats().issued, uint64_t(0));
+}
+
+TEST_CASE(Recorder_OnlyChangedConstantBufferRangeIsForwarded) {
+    std::vector<Call> calls;
+    StateRecorder recorder(std::make_unique<MockBindings>(calls));
+
+    const Handle initial[] = {handle(10), handle(11), handle(12), handle(13)};
+    recorder.setConstantBuffers(0, 4, initial);
+    calls.clear();
+
+    const Handle updated[] = {handle(10), handle(21), handle(22), handle(13)};
+    recorder.setConstantBuffers(0, 4, updated);
+
+    CHECK_EQ(calls.size(), size_t(1));
+    CHECK(calls[0].type == Call::Type::ConstantBuffers);
+    CHECK_EQ(calls[0].startSlot, uint32_t(1));
+    CHECK(calls[0].handles == std::vector<Handle>({handle(21), handle(22)}));
+}
+
+TEST_CASE(Recorder_InvalidateForcesReissue) {
+    std::vector<Call> calls;
+    StateRecorder recorder(std::make_unique<MockBindings>(calls));
+
+    const Handle buffers[] = {handle(10)};
+    recorder.setShader(handle(1));
+    recorder.setConstantBuffers(0, 1, buffers);
+    recorder.setShaderResource(0, handle(100));
+    recorder.dispatch(1, 1, 1);
+    calls.clear();
+
+    recorder.invalidate();
+    recorder.setShader(handle(1));
+    recorder.setConstantBuffers(0, 1, buffers);
+    recorder.setShaderResource(0, handle(100));
+    recorder.dispatch(1, 1, 1);
+
+    CHECK_EQ(countCalls(calls, Call::Type::Shader), size_t(1));
+    CHECK_EQ(countCalls(calls, Call::Type::ConstantBuffers), size_t(1));
+    CHECK(lastViews(calls, Call::Type::ShaderResources) == std::vector<Handle>({handle(100)}));
+}
+
+TEST_CASE(Recorder_ViewsAreAppliedAtDispatch) {
+    std::vector<Call> calls;
+    StateRecorder recorder(std::make_unique<MockBindings>(calls));
+
+    recorder.setShaderResource(0, handle(100));
+    recorder.setUnorderedAccessView(0, handle(200));
+    CHECK(calls.empty());
+
+    recorder.dispatch(8, 8, 1);
+    // The slots the application may have used are reset too: the SRVs by the clear that precedes the UAVs.
+    const std::vector<Handle> expectedUavs{handle(200), nullptr, nullptr, nullptr};
+    CHECK(lastViews(calls, Call::Type::ShaderResources) == std::vector<Handle>({handle(100)}));
+    CHECK(lastViews(calls, Call::Type::UnorderedAccessViews) == expectedUavs);
+    CHECK(!calls.empty() && calls.back().type == Call::Type::Dispatch);
+
+    // Same views for the next pass: only the dispatch goes through.
+    calls.clear();
+    recorder.setShaderResource(0, handle(100));
+    recorder.setUnorderedAccessView(0, handle(200));
+    recorder.dispatch(8, 8, 1);
+    CHECK_EQ(calls.size(), size_t(1));
+    CHECK(calls[0].type == Call::Type::Dispatch);
+}
+
+TEST_CASE(Recorder_ShaderResourceIsClearedBeforeUnorderedAccessView) {
+    std::vector<Call> calls;
+    StateRecorder recorder(std::make_unique<MockBindings>(calls));
+
+    // Pass 1 reads texture A and writes texture B.
+    recorder.setShaderResource(0, handle(100));
+    recorder.setUnorderedAccessView(0, handle(201));
+    recorder.dispatch(1, 1, 1);
+    calls.clear();
+
+    // Pass 2 reads texture B and writes texture A.
+    recorder.setShaderResource(0, handle(101));
+    recorder.setUnorderedAccessView(0, handle(200));
+    recorder.dispatch(1, 1, 1);
+
+    CHECK_EQ(calls.size(), size_t(4));
+    if (calls.size() == 4) {
+        CHECK(calls[0].type == Call::Type::ShaderResources);
+        CHECK(calls[0].handles == std::vector<Handle>({nullptr}));
+        CHECK(calls[1].type == Call::Type::UnorderedAccessViews);
+        CHECK(calls[1].handles == std::vector<Handle>({handle(200)}));
+        CHECK(calls[2].type == Call::Type::ShaderResources);
+        CHECK(calls[2].handles == std::vector<Handle>({handle(101)}));
+        CHECK(calls[3].type == Call::Type::Dispatch);
+    }
+}
+
+TEST_CASE(Recorder_UnbindIssuesOneCallPerViewType) {
+    std::vector<Call> calls;
+    StateRecorder recorder(std::make_unique<MockBindings>(calls));
+
+    recorder.setShaderResource(0, handle(100));
+    recorder.setShaderResource(2, handle(102));
+    recorder.setUnorderedAccessView(1, handle(201));
+    recorder.dispatch(1, 1, 1);
+    calls.clear();
+
+    recorder.unbindResources();
+    CHECK_EQ(countCalls(calls, Call::Type::ShaderResources), size_t(1));
+    CHECK_EQ(countCalls(calls, Call::Type::UnorderedAccessViews), size_t(1));
+    for (const Call& call : calls) {
+        CHECK(std::all_of(call.handles.cbegin(), call.handles.cend(), [](Handle h) { return h == nullptr; }));
+    }
+
+    // Nothing is left bound, so unbinding again is free.
+    calls.clear();
+    recorder.unbindResources();
+    CHECK(calls.empty());
+}
@@ -0,0 +1,144 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+#include <utils/stats.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+    using namespace openxr_api_layer::utils::stats;
+
+    // Every field is derived from the frame number, so that a snapshot mixing two frames is detected.
+    FrameStats makeStats(uint64_t frame) {
+        FrameStats stats{};
+        stats.sessionId = 7;
+        stats.framesProcessed = frame;
+        for (uint32_t i = 0; i < (uint32_t)SkipReason::Count; i++) {
+            stats.framesSkipped[i] = frame * 3 + i;
+        }
+        stats.endFrameCpuUsTotal = frame * 100;
+        stats.endFrameCpuUsLast = (uint32_t)frame;
+        stats.endFrameCpuUsAverage = (float)(frame % 1000);
+        for (uint32_t i = 0; i < (uint32_t)GpuStage::Count; i++) {
+            stats.gpuMs[i] = (float)(frame % 1000) + i;
+        }
+        stats.poolBytes = frame << 20;
+        stats.configGeneration = (uint32_t)frame;
+        return stats;
+    }
+
+    // The block is named after the process: a Win32 file mapping, or a POSIX shm_open() object elsewhere.
+    uint32_t getProcessId() {
+#ifdef _WIN32
+        return GetCurrentProcessId();
+#else
+        return (uint32_t)getpid();
+#endif
+    }
+
+    bool isConsistent(const FrameStats& stats) {
+        const FrameStats expected = makeStats(stats.framesProcessed);
+        return memcmp(&stats, &expected, sizeof(stats)) == 0;
+    }
+
+} // namespace
+
+TEST_CASE(Stats_ReaderNeedsAWriter) {
+    StatsReader reader;
+    CHECK(!reader.open(getProcessId()));
+    CHECK(!reader.read().has_value());
+}
+
+TEST_CASE(Stats_ReaderSeesPublishedSnapshot) {
+    StatsWriter writer;
+    CHECK(writer.open());
+
+    StatsReader reader;
+    CHECK(reader.open(getProcessId()));
+
+    // Nothing published yet: the block reads as zeroes.
+    const auto initial = reader.read();
+    CHECK(initial.has_value() && initial->framesProcessed == 0);
+
+    writer.publish(makeStats(42));
+    const auto stats = reader.read();
+    CHECK(stats.has_value() && stats->framesProcessed == 42 && isConsistent(*stats));
+
+    reader.close();
+    writer.close();
+    CHECK(!reader.open(getProcessId()));
+}
+
+TEST_CASE(Stats_SnapshotsAreNeverTorn) {
+    StatsWriter writer;
+    CHECK(writer.open());
+    writer.publish(makeStats(0));
+
+    StatsReader reader;
+    CHECK(reader.open(getProcessId()));
+
+    // The writer publishes until the reader has seen enough snapshots.
+    std::atomic<bool> stop{false};
+    uint64_t lastPublished = 0;
+    std::thread publisher([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            writer.publish(makeStats(++lastPublished));
+        }
+    });
+
+    uint64_t reads = 0, torn = 0, backwards = 0, lastFrame = 0;
+    for (uint32_t attempt = 0; attempt < 10000000 && reads < 20000; attempt++) {
+        const auto stats = reader.read();
+        if (!stats) {
+            // The writer kept the block busy during all the attempts, which is allowed.
+            continue;
+        }
+        reads++;
+        if (!isConsistent(*stats)) {
+            torn++;
+        }
+        if (stats->framesProcessed < lastFrame) {
+            backwards++;
+        }
+        lastFrame = stats->framesProcessed;
+    }
+    stop.store(true, std::memory_order_relaxed);
+    publisher.join();
+
+    CHECK_EQ(reads, uint64_t(20000));
+    CHECK_EQ(torn, uint64_t(0));
+    CHECK_EQ(backwards, uint64_t(0));
+
+    // Once the writer is idle, the last snapshot is always readable.
+    const auto last = reader.read();
+    CHECK(last.has_value() && last->framesProcessed == lastPublished);
+}
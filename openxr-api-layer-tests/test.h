@@ -0,0 +1,64 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+// A minimal unit test harness: each TEST_CASE registers itself at static initialization, and main() runs them all.
+
+namespace openxr_api_layer::tests {
+
+    using TestFunction = void (*)();
+
+    struct TestCase {
+        const char* name;
+        TestFunction function;
+    };
+
+    std::vector<TestCase>& getTestCases();
+
+    // Record a failed check. The test keeps running so that all the failures of a test are reported at once.
+    void reportFailure(const char* file, int line, const char* expression);
+
+    struct TestRegistration {
+        TestRegistration(const char* name, TestFunction function) {
+            getTestCases().push_back({name, function});
+        }
+    };
+
+} // namespace openxr_api_layer::tests
+
+#define TEST_CASE(name)                                                                                                \
+    static void name();                                                                                                \
+    static const openxr_api_layer::tests::TestRegistration name##_registration(#name, &name);                          \
+    static void name()
+
+#define CHECK(expression)                                                                                              \
+    do {                                                                                                               \
+        if (!(expression)) {                                                                                           \
+            openxr_api_layer::tests::reportFailure(__FILE__, __LINE__, #expression);                                   \
+        }                                                                                                              \
+    } while (false)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
@@ -0,0 +1,246 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "test.h"
+
+#include <utils/texturepool.h>
+
+namespace {
+
+    using namespace openxr_api_layer::utils::texturepool;
+
+    constexpr uint64_t MB = 1024 * 1024;
+
+    const Key KeyA{128, 128, 1};
+    const Key KeyB{256, 256, 1};
+    const Key KeyC{128, 128, 2};
+
+    // Acquire a new entry and release it right away, as a dispatch does.
+    uint32_t use(Allocator& allocator, const Key& key, uint64_t bytes) {
+        bool created = false;
+        const auto id = allocator.acquire(key, bytes, created);
+        CHECK(id.has_value());
+        allocator.release(id.value_or(0));
+        return id.value_or(0);
+    }
+
+    void advance(Allocator& allocator, uint64_t frames) {
+        for (uint64_t i = 0; i < frames; i++) {
+            allocator.beginFrame();
+        }
+    }
+
+    struct FakeTextures {
+        int generation{0};
+    };
+
+} // namespace
+
+TEST_CASE(TexturePool_KeysAreBucketed) {
+    const Key key = makeKey(1000, 129, 7);
+    CHECK_EQ(key.width, uint32_t(1024));
+    CHECK_EQ(key.height, uint32_t(256));
+    CHECK_EQ(key.format, uint32_t(7));
+    CHECK(makeKey(1024, 256, 7) == key);
+
+    const Key exact = makeKey(1000, 129, 7, 1);
+    CHECK_EQ(exact.width, uint32_t(1000));
+    CHECK_EQ(exact.height, uint32_t(129));
+}
+
+TEST_CASE(TexturePool_IdleEntriesAreReused) {
+    Allocator allocator;
+    allocator.beginFrame();
+
+    bool created = false;
+    const auto first = allocator.acquire(KeyA, MB, created);
+    CHECK(first.has_value() && created);
+
+    // In use: a second acquisition of the same key gets its own entry.
+    const auto second = allocator.acquire(KeyA, MB, created);
+    CHECK(second.has_value() && created && *second != *first);
+    allocator.release(*first);
+    allocator.release(*second);
+
+    const auto reused = allocator.acquire(KeyA, MB, created);
+    CHECK(reused.has_value() && !created);
+
+    // A different format never matches.
+    const auto other = allocator.acquire(KeyC, MB, created);
+    CHECK(other.has_value() && created);
+
+    CHECK_EQ(allocator.getStats().entries, uint32_t(3));
+    CHECK_EQ(allocator.getStats().inUse, uint32_t(2));
+    CHECK_EQ(allocator.getStats().bytes, 3 * MB);
+}
+
+TEST_CASE(TexturePool_BudgetEvictsOnlyAfterHoldFrames) {
+    Allocator allocator;
+    allocator.setLimits(2 * MB, 16 * MB);
+    allocator.beginFrame();
+    const uint32_t a = use(allocator, KeyA, MB);
+    allocator.beginFrame();
+    const uint32_t b = use(allocator, KeyB, MB);
+    const uint32_t c = use(allocator, KeyC, MB);
+    CHECK_EQ(allocator.getStats().bytes, 3 * MB);
+
+    // Over the budget, but the GPU may still use the entries: a has been idle for HoldFrames - 1 frames.
+    advance(allocator, Allocator::HoldFrames - 2);
+    CHECK(allocator.getEvicted().empty());
+    CHECK_EQ(allocator.getStats().bytes, 3 * MB);
+
+    // The least recently used entry goes first, and only until the pool fits the budget.
+    allocator.beginFrame();
+    CHECK(allocator.getEvicted() == std::vector<uint32_t>({a}));
+    CHECK_EQ(allocator.getStats().bytes, 2 * MB);
+    CHECK_EQ(allocator.getStats().entries, uint32_t(2));
+    allocator.getEvicted().clear();
+
+    // Within the budget, idle entries stay.
+    advance(allocator, 10);
+    CHECK(allocator.getEvicted().empty());
+
+    bool created = false;
+    const auto reused = allocator.acquire(KeyB, MB, created);
+    CHECK(reused.has_value() && !created && *reused == b);
+    (void)c;
+}
+
+TEST_CASE(TexturePool_EntriesInUseAreNeverEvicted) {
+    Allocator allocator;
+    allocator.setLimits(0, 16 * MB);
+    allocator.beginFrame();
+    bool created = false;
+    const auto held = allocator.acquire(KeyA, MB, created);
+    CHECK(held.has_value());
+
+    advance(allocator, 10);
+    CHECK(allocator.getEvicted().empty());
+
+    allocator.release(*held);
+    advance(allocator, Allocator::HoldFrames);
+    CHECK(allocator.getEvicted() == std::vector<uint32_t>({*held}));
+    CHECK_EQ(allocator.getStats().bytes, uint64_t(0));
+}
+
+TEST_CASE(TexturePool_CapEvictsIdleEntriesImmediately) {
+    Allocator allocator;
+    allocator.setLimits(2 * MB, 2 * MB);
+    allocator.beginFrame();
+    const uint32_t a = use(allocator, KeyA, MB);
+    const uint32_t b = use(allocator, KeyB, MB);
+
+    // A new entry would go over the cap: an idle entry is evicted, even one used this frame.
+    bool created = false;
+    const auto c = allocator.acquire(KeyC, MB, created);
+    CHECK(c.has_value() && created);
+    CHECK(allocator.getEvicted() == std::vector<uint32_t>({a}));
+    CHECK_EQ(allocator.getStats().bytes, 2 * MB);
+
+    // Its id is recycled.
+    CHECK(c.has_value() && *c == a);
+    (void)b;
+}
+
+TEST_CASE(TexturePool_CapFailsWhenEverythingIsInUse) {
+    Allocator allocator;
+    allocator.setLimits(2 * MB, 2 * MB);
+    allocator.beginFrame();
+    bool created = false;
+    const auto a = allocator.acquire(KeyA, MB, created);
+    const auto b = allocator.acquire(KeyB, MB, created);
+    CHECK(a.has_value() && b.has_value());
+
+    CHECK(!allocator.acquire(KeyC, MB, created).has_value());
+    CHECK(!allocator.acquire(KeyC, 4 * MB, created).has_value());
+    CHECK(allocator.getEvicted().empty());
+    CHECK_EQ(allocator.getStats().bytes, 2 * MB);
+    CHECK_EQ(allocator.getStats().peakBytes, 2 * MB);
+
+    // Once an entry is released, it makes room.
+    allocator.release(*a);
+    CHECK(allocator.acquire(KeyC, MB, created).has_value());
+}
+
+TEST_CASE(TexturePool_CapIsAtLeastTheBudget) {
+    Allocator allocator;
+    allocator.setLimits(4 * MB, MB);
+    allocator.beginFrame();
+    bool created = false;
+    CHECK(allocator.acquire(KeyA, 2 * MB, created).has_value());
+    CHECK(allocator.acquire(KeyB, 2 * MB, created).has_value());
+    CHECK(!allocator.acquire(KeyC, MB, created).has_value());
+}
+
+TEST_CASE(TexturePool_DiscardFreesTheEntry) {
+    Allocator allocator;
+    allocator.beginFrame();
+    bool created = false;
+    const auto id = allocator.acquire(KeyA, MB, created);
+    CHECK(id.has_value());
+    allocator.discard(*id);
+    CHECK_EQ(allocator.getStats().bytes, uint64_t(0));
+    CHECK_EQ(allocator.getStats().entries, uint32_t(0));
+    CHECK_EQ(allocator.getStats().inUse, uint32_t(0));
+
+    // Not an eviction: the caller already dropped the textures.
+    CHECK(allocator.getEvicted().empty());
+    const auto again = allocator.acquire(KeyA, MB, created);
+    CHECK(again.has_value() && created && *again == *id);
+}
+
+TEST_CASE(TexturePool_PoolReleasesEvictedTextures) {
+    Pool<FakeTextures> pool;
+    pool.setLimits(0, 16 * MB);
+    CHECK_EQ(pool.beginFrame(), uint32_t(0));
+
+    uint32_t firstId = 0, secondId = 0;
+    bool created = false;
+    FakeTextures* first = pool.acquire(KeyA, MB, firstId, created);
+    CHECK(first && created);
+    first->generation = 1;
+
+    // Entries stay in place while the pool grows.
+    FakeTextures* second = pool.acquire(KeyB, MB, secondId, created);
+    CHECK(second && created);
+    second->generation = 2;
+    CHECK_EQ(first->generation, 1);
+    pool.release(firstId);
+    pool.release(secondId);
+
+    uint32_t evicted = 0;
+    for (uint64_t i = 0; i < Allocator::HoldFrames; i++) {
+        evicted += pool.beginFrame();
+    }
+    CHECK_EQ(evicted, uint32_t(2));
+    CHECK_EQ(pool.getStats().entries, uint32_t(0));
+
+    // A new entry in a recycled slot starts from default textures.
+    uint32_t id = 0;
+    FakeTextures* fresh = pool.acquire(KeyA, MB, id, created);
+    CHECK(fresh && created && fresh->generation == 0);
+}
@@ -1,7 +1,13 @@
 # The list of OpenXR functions our layer will override.
 override_functions = [
     "xrGetSystem",
+    "xrEnumerateViewConfigurationViews",
+    "xrWaitFrame",
+    "xrBeginFrame",
     "xrCreateSession",
+    "xrDestroySession",
+    "xrCreateSwapchain",
+    "xrDestroySwapchain",
     "xrEndFrame",
     "xrAcquireSwapchainImage",
     "xrReleaseSwapchainImage",
@@ -30,12 +30,14 @@ namespace {
 namespace openxr_api_layer::log {
     extern std::ofstream logStream;
 
+#ifdef _WIN32
     // {cbf3adcd-42b1-4c38-830c-91980af201f8}
     TRACELOGGING_DEFINE_PROVIDER(g_traceProvider,
                                  "OpenXRTemplate",
                                  (0xcbf3adcd, 0x42b1, 0x4c38, 0x83, 0x0c, 0x91, 0x98, 0x0a, 0xf2, 0x01, 0xf8));
 
     TraceLoggingActivity<g_traceProvider> g_traceActivity;
+#endif
 
     namespace {
 
@@ -45,8 +47,12 @@ namespace openxr_api_layer::log {
 
             char buf[1024];
             size_t offset = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %z: ", std::localtime(&now));
+#ifdef _WIN32
             vsnprintf_s(buf + offset, sizeof(buf) - offset, _TRUNCATE, fmt, va);
             OutputDebugStringA(buf);
+#else
+            vsnprintf(buf + offset, sizeof(buf) - offset, fmt, va);
+#endif
             if (logStream.is_open()) {
                 logStream << buf;
                 logStream.flush();
@@ -26,6 +26,8 @@
 
 namespace openxr_api_layer::log {
 
+    // Tracing is Windows-only. The logging functions below also build elsewhere, for the unit tests of the utilities.
+#ifdef _WIN32
     TRACELOGGING_DECLARE_PROVIDER(g_traceProvider);
 
     extern TraceLoggingActivity<g_traceProvider> g_traceGlobal;
@@ -40,6 +42,7 @@ namespace openxr_api_layer::log {
 #define TLXArg TLArg
 #else
 #define TLXArg TLPArg
+#endif
 #endif
 
     // General logging function.
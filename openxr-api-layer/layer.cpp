@@ -29,6 +29,20 @@
 #include <log.h>
 #include <util.h>
 #include "utils/graphics.h"
+#include "utils/formats.h"
+#include "utils/frameplan.h"
+#include "utils/dynres.h"
+#include "utils/shadercache.h"
+#include "utils/worker.h"
+#include "utils/constants.h"
+#include "utils/recorder.h"
+#include "utils/profiler.h"
+#include "utils/stats.h"
+#include "utils/telemetry.h"
+#include "utils/d3d12passes.h"
+#include "utils/passgraph.h"
+#include "utils/texturepool.h"
+#include "shaders/shaders.gen.h"
 #include <d3dcompiler.h>
 
 // CAS CPU setup headers
@@ -47,6 +61,8 @@ namespace openxr_api_layer {
     const std::vector<std::string> blockedExtensions = {};
     const std::vector<std::string> implicitExtensions = {};
 
+    struct TempTextures { Microsoft::WRL::ComPtr<ID3D11Texture2D> input; Microsoft::WRL::ComPtr<ID3D11Texture2D> output; UINT width{}, height{}; DXGI_FORMAT format{}; };
+
     struct SessionState : utils::graphics::ICompositionSessionData {
         std::shared_ptr<utils::graphics::ICompositionFramework> composition;
 
@@ -54,26 +70,96 @@ namespace openxr_api_layer {
         Microsoft::WRL::ComPtr<ID3D11Device> appD3DDevice;
         Microsoft::WRL::ComPtr<ID3D11DeviceContext> appD3DContext;
 
-        // D3D11 CAS objects on app device
-        Microsoft::WRL::ComPtr<ID3D11ComputeShader> cs;
-        Microsoft::WRL::ComPtr<ID3D11Buffer> constCB;
+        // Set instead of the above for D3D12 sessions: the passes are then recorded by the D3D12 backend and submitted
+        // to the application's queue, and the D3D11-only objects below stay unused.
+        Microsoft::WRL::ComPtr<ID3D12Device> appD3D12Device;
+        Microsoft::WRL::ComPtr<ID3D12CommandQueue> appD3D12Queue;
+        std::unique_ptr<utils::d3d12passes::Backend> d3d12;
+
+        // Guards the shaders, store plans and warm textures, which the worker thread fills in.
+        std::mutex objectsMutex;
+
+        // D3D11 post-processing shaders on app device, one entry per permutation (see makeShaderKey()). A null entry
+        // records a permutation that failed to build.
+        std::unordered_map<uint32_t, Microsoft::WRL::ComPtr<ID3D11ComputeShader>> shaders;
+
+        // Same for the pipelines of D3D12 sessions.
+        std::unordered_map<uint32_t, Microsoft::WRL::ComPtr<ID3D12PipelineState>> pipelines;
+
+        // Permutations queued on the worker thread.
+        std::unordered_set<uint32_t> pendingShaders;
+
+        // How to write each swapchain format seen so far, queried once per device.
+        std::unordered_map<DXGI_FORMAT, std::optional<utils::formats::StorePlan>> storePlans;
+
+        // Temporary textures created ahead of the first frame, handed over to the texture pool at xrEndFrame.
+        struct WarmTextures {
+            utils::texturepool::Key key;
+            TempTextures textures;
+        };
+        std::vector<WarmTextures> warmTextures;
+
+        // Set once the objects created by ensureCasObjects() can be used. Until then, frames are not processed.
+        std::atomic<bool> ready{false};
+
+        // Constant buffers of every pass, per swapchain slice (see makeConstantsKey()). Only used on the application's
+        // thread.
+        utils::constants::ConstantBufferCache constants;
+
+        // The chain of passes of the view being processed, rebuilt for every view. Only used on the application's
+        // thread.
+        utils::passgraph::PassGraph passGraph;
+
+        // The multisampled swapchain image slices resolved in the current frame, shared by all the views of a slice
+        // (see getResolvedSlice()). Only used on the application's thread.
+        struct ResolvedSlice {
+            ID3D11Texture2D* source;
+            uint32_t arraySlice;
+            ID3D11Texture2D* texture;
+            uint32_t poolId;
+        };
+        std::vector<ResolvedSlice> resolvedSlices;
+
+        // Compute bindings of the passes, skipping the ones already in place. Invalidated at every xrEndFrame(), since
+        // the application uses the same context in between.
+        std::unique_ptr<utils::recorder::StateRecorder> recorder;
+
+        // How the application's compute state is preserved across the layer's passes.
+        enum class StateRestore { None, Targeted, ContextState };
+        StateRestore stateRestore{StateRestore::Targeted};
+        utils::recorder::ComputeStateSnapshot appComputeState;
+        Microsoft::WRL::ComPtr<ID3DDeviceContextState> layerContextState;
+        Microsoft::WRL::ComPtr<ID3DDeviceContextState> appContextState;
+
         float sharpness{0.6f};
-        Microsoft::WRL::ComPtr<ID3D11Buffer> debugCB;
 
-        // Timing queries
+        // Timing queries: a timestamp before each pass and one after the last (see utils::stats::GpuStage). They are
+        // read back once the GPU is done with them, and not reissued until then.
         Microsoft::WRL::ComPtr<ID3D11Query> qDisjoint;
-        Microsoft::WRL::ComPtr<ID3D11Query> qBegin;
-        Microsoft::WRL::ComPtr<ID3D11Query> qEnd;
+        Microsoft::WRL::ComPtr<ID3D11Query> qTimestamps[(uint32_t)utils::stats::GpuStage::Count + 1];
+        bool timingPending{false};
         uint32_t timingFrameCounter{0};
         double timingAccumMs{0.0};
 
-        // Config reload
-        std::filesystem::file_time_type cfgLastWriteTime{};
+        // Published over shared memory at every xrEndFrame().
+        utils::stats::FrameStats stats{};
+        uint32_t stateRestoreCounter{0};
+        double stateRestoreAccumMs{0.0};
+
+        // Config reload, one timestamp per config file (%LOCALAPPDATA% then DLL folder)
+        std::pair<std::filesystem::file_time_type, std::filesystem::file_time_type> cfgLastWriteTimes{};
+        std::chrono::steady_clock::time_point cfgLastCheck{};
 
         // Shader init state
         bool shaderInitAttempted{false};
         bool shaderInitFailed{false};
 
+        // Use the exact sRGB transfer function instead of the x^2/sqrt approximation
+        bool srgbExact{false};
+
+        // Create the output swapchains in the runtime's preferred format rather than the application's
+        bool runtimeOutputFormat{false};
+
         // Debug controls
         uint32_t debugFramesMax{60};
         bool debugOverlay{false};
@@ -86,16 +172,15 @@ namespace openxr_api_layer {
         float levelsOutWhite{1.0f};
         float levelsGamma{1.0f};
 
-        Microsoft::WRL::ComPtr<ID3D11ComputeShader> levelsCS;
-        Microsoft::WRL::ComPtr<ID3D11Buffer> levelsCB;
-
         // FakeHDR controls
         bool fakeHdrEnabled{false};
         float fakeHdrPower{1.30f};
         float fakeHdrRadius1{0.793f};
         float fakeHdrRadius2{0.87f};
-        Microsoft::WRL::ComPtr<ID3D11ComputeShader> fakeHdrCS;
-        Microsoft::WRL::ComPtr<ID3D11Buffer> fakeHdrCB;
+
+        // Builds the objects above off the application's frame loop. Null if the device is single-threaded, in which
+        // case everything is built on the calling thread. Declared last so that it stops before the rest is destroyed.
+        std::unique_ptr<utils::worker::Worker> worker;
     };
 
     static float readSharpnessFromEnv() {
@@ -183,6 +268,51 @@ namespace openxr_api_layer {
         return std::nullopt;
     }
 
+    // Settings are read from both config files, so both are watched. A missing file reads as the epoch, so that
+    // creating or deleting one also counts as a change.
+    static std::pair<std::filesystem::file_time_type, std::filesystem::file_time_type> getConfigWriteTimes() {
+        const auto writeTime = [](const std::filesystem::path& path) {
+            std::error_code ec;
+            const auto time = std::filesystem::last_write_time(path, ec);
+            return ec ? std::filesystem::file_time_type{} : time;
+        };
+        return {writeTime(openxr_api_layer::localAppData / "config.cfg"),
+                writeTime(openxr_api_layer::dllHome / "config.cfg")};
+    }
+
+    static float resolveSharpnessFromConfigOrEnv();
+
+    // Read the settings that can change while a session runs: sharpness and the Levels and FakeHDR parameters.
+    static void readConfigTunables(SessionState* state) {
+        state->sharpness = resolveSharpnessFromConfigOrEnv();
+        if (auto s = tryReadConfigValue("levels_in_black")) try { state->levelsInBlack = std::stof(*s); } catch (...) {}
+        if (auto s = tryReadConfigValue("levels_in_white")) try { state->levelsInWhite = std::stof(*s); } catch (...) {}
+        if (auto s = tryReadConfigValue("levels_out_black")) try { state->levelsOutBlack = std::stof(*s); } catch (...) {}
+        if (auto s = tryReadConfigValue("levels_out_white")) try { state->levelsOutWhite = std::stof(*s); } catch (...) {}
+        if (auto s = tryReadConfigValue("levels_gamma")) try { state->levelsGamma = std::stof(*s); } catch (...) {}
+        if (auto s = tryReadConfigValue("fakehdr_power")) try { state->fakeHdrPower = std::stof(*s); } catch (...) {}
+        if (auto s = tryReadConfigValue("fakehdr_radius1")) try { state->fakeHdrRadius1 = std::stof(*s); } catch (...) {}
+        if (auto s = tryReadConfigValue("fakehdr_radius2")) try { state->fakeHdrRadius2 = std::stof(*s); } catch (...) {}
+    }
+
+    // Pick up edits of the config files, checking their timestamps at most once per second.
+    static void reloadConfigIfChanged(SessionState* state) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - state->cfgLastCheck < 1s) {
+            return;
+        }
+        state->cfgLastCheck = now;
+        const auto writeTimes = getConfigWriteTimes();
+        if (writeTimes == state->cfgLastWriteTimes) {
+            return;
+        }
+        utils::profiler::Scope scope("ReloadConfig");
+        state->cfgLastWriteTimes = writeTimes;
+        state->stats.configGeneration++;
+        readConfigTunables(state);
+        Log(fmt::format("Config reloaded, CAS sharpness set to {:.3f}\n", state->sharpness));
+    }
+
     static float resolveSharpnessFromConfigOrEnv() {
         // Priority: env -> %LOCALAPPDATA% config -> DLL folder config -> default
         // Env already clamps and defaults if not set.
@@ -196,7 +326,6 @@ namespace openxr_api_layer {
         try {
             auto cfgPath = openxr_api_layer::localAppData / "config.cfg";
             if (auto val = tryReadSharpnessFromConfigFile(cfgPath)) {
-                Log(fmt::format("Loaded sharpness from config: {}\\n", cfgPath.string()));
                 return *val;
             }
         } catch (...) {
@@ -206,7 +335,6 @@ namespace openxr_api_layer {
         try {
             auto cfgPath = openxr_api_layer::dllHome / "config.cfg";
             if (auto val = tryReadSharpnessFromConfigFile(cfgPath)) {
-                Log(fmt::format("Loaded sharpness from config: {}\\n", cfgPath.string()));
                 return *val;
             }
         } catch (...) {
@@ -215,31 +343,29 @@ namespace openxr_api_layer {
         return 0.6f;
     }
 
-    static bool ensureCasObjects(SessionState* s) {
-        if (!s || !s->appD3DDevice) return false;
-        if (s->cs && (!s->levelsEnabled || s->levelsCS) && (!s->fakeHdrEnabled || s->fakeHdrCS)) return true;
-        if (s->shaderInitAttempted && s->shaderInitFailed) return false;
-        s->shaderInitAttempted = true;
-        ID3D11Device* d3d = s->appD3DDevice.Get();
+    // The post-processing passes. Each pass is built into several permutations (see shaders/Store.hlsli).
+    enum class ShaderPass : uint32_t { Cas = 0, FakeHdr, Levels };
+
+    // The compile-time options of a pass, selected from the swapchain format. scaling only applies to the CAS pass.
+    // outputEncoding is the encoding of the values stored, which only differs from encoding in the last pass of a chain
+    // writing to a destination of another format.
+    struct ShaderPermutation {
+        utils::formats::StoreMode storeMode{utils::formats::StoreMode::Typed};
+        utils::formats::ColorEncoding encoding{utils::formats::ColorEncoding::Linear};
+        utils::formats::ColorEncoding outputEncoding{utils::formats::ColorEncoding::Linear};
+        bool scaling{false};
+    };
 
-        // Try loading precompiled CAS.cso first
-        bool shaderCreated = false;
-        do {
-            auto csoPath = (dllHome / "shaders" / "CAS.cso");
-            if (std::filesystem::exists(csoPath)) {
-                try {
-                    std::ifstream fin(csoPath, std::ios::binary);
-                    std::vector<char> bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
-                    if (!bytes.empty() && SUCCEEDED(d3d->CreateComputeShader(bytes.data(), bytes.size(), nullptr, s->cs.ReleaseAndGetAddressOf()))) {
-                        Log(fmt::format("CAS shader loaded: {}\n", csoPath.string()));
-                        shaderCreated = true;
-                        break;
-                    }
-                } catch (...) {
-                }
-            }
+    static uint32_t makeShaderKey(ShaderPass pass, const ShaderPermutation& permutation) {
+        return (uint32_t)pass | ((uint32_t)permutation.storeMode << 8) | ((uint32_t)permutation.encoding << 16) |
+               ((uint32_t)permutation.outputEncoding << 20) | ((uint32_t)permutation.scaling << 24);
+    }
+
+    using PFN_D3DCompileFromFile = HRESULT(WINAPI*)(LPCWSTR, const D3D_SHADER_MACRO*, ID3DInclude*, LPCSTR, LPCSTR, UINT, UINT, ID3DBlob**, ID3DBlob**);
 
-            // Fallback: compile CAS compute shader from HLSL
+    // Load d3dcompiler_47.dll once, it stays loaded for the lifetime of the process.
+    static PFN_D3DCompileFromFile getD3DCompileFromFile() {
+        static const PFN_D3DCompileFromFile pfn = []() -> PFN_D3DCompileFromFile {
             HMODULE d3dCompiler = LoadLibraryW(L"d3dcompiler_47.dll");
             if (!d3dCompiler) {
                 // Try next to our DLL as a fallback
@@ -247,445 +373,1391 @@ namespace openxr_api_layer {
                 d3dCompiler = LoadLibraryW(localDll.c_str());
             }
             if (!d3dCompiler) {
-                ErrorLog("d3dcompiler_47.dll not found; CAS disabled\n");
-                break;
-            }
-            using PFN_D3DCompileFromFile = HRESULT(WINAPI*)(LPCWSTR, const D3D_SHADER_MACRO*, ID3DInclude*, LPCSTR, LPCSTR, UINT, UINT, ID3DBlob**, ID3DBlob**);
-            auto pD3DCompileFromFile = reinterpret_cast<PFN_D3DCompileFromFile>(GetProcAddress(d3dCompiler, "D3DCompileFromFile"));
-            if (!pD3DCompileFromFile) {
-                FreeLibrary(d3dCompiler);
-                break;
-            }
-            std::wstring shaderPathW = (dllHome / "shaders" / "CAS.hlsl").wstring();
-            std::string shaderPath(shaderPathW.begin(), shaderPathW.end());
-            Microsoft::WRL::ComPtr<ID3DBlob> blob, err;
-            UINT flags = D3DCOMPILE_OPTIMIZATION_LEVEL3;
-            if (FAILED(pD3DCompileFromFile(shaderPathW.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "mainCS", "cs_5_0", flags, 0, blob.ReleaseAndGetAddressOf(), err.ReleaseAndGetAddressOf()))) {
-                std::string errMsg;
-                if (err) errMsg.assign((const char*)err->GetBufferPointer(), err->GetBufferSize());
-                ErrorLog(fmt::format("Failed to compile CAS.hlsl: {}\n{}\n", shaderPath, errMsg));
-                FreeLibrary(d3dCompiler);
-                break;
-            }
-            if (FAILED(d3d->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, s->cs.ReleaseAndGetAddressOf()))) {
-                FreeLibrary(d3dCompiler);
-                break;
-            }
-            FreeLibrary(d3dCompiler);
-            Log(fmt::format("CAS shader compiled: {}\n", shaderPath));
-            shaderCreated = true;
-        } while (false);
-        if (!shaderCreated) { s->shaderInitFailed = true; return false; }
-
-        // Create Levels shader if enabled
-        if (s->levelsEnabled && !s->levelsCS) {
-            HMODULE d3dCompiler = LoadLibraryW(L"d3dcompiler_47.dll");
-            std::wstring shaderPathW = (dllHome / L"shaders" / L"Levels.hlsl").wstring();
-            Microsoft::WRL::ComPtr<ID3DBlob> blob, err;
-            if (d3dCompiler) {
-                auto pD3DCompileFromFile = reinterpret_cast<HRESULT(WINAPI*)(LPCWSTR, const D3D_SHADER_MACRO*, ID3DInclude*, LPCSTR, LPCSTR, UINT, UINT, ID3DBlob**, ID3DBlob**)>(GetProcAddress(d3dCompiler, "D3DCompileFromFile"));
-                if (pD3DCompileFromFile && SUCCEEDED(pD3DCompileFromFile(shaderPathW.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "mainCS", "cs_5_0", 0, 0, blob.ReleaseAndGetAddressOf(), err.ReleaseAndGetAddressOf()))) {
-                    d3d->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, s->levelsCS.ReleaseAndGetAddressOf());
-                    Log("Levels shader compiled\n");
+                ErrorLog("d3dcompiler_47.dll not found\n");
+                return nullptr;
+            }
+            return reinterpret_cast<PFN_D3DCompileFromFile>(GetProcAddress(d3dCompiler, "D3DCompileFromFile"));
+        }();
+        return pfn;
+    }
+
+    // Hash everything a compiled permutation depends on besides its compile options: the shader sources and the
+    // compiler DLL (identified by its metadata, so that it does not need to be loaded). Computed once per process.
+    static uint64_t getShaderSourcesHash() {
+        static const uint64_t sourcesHash = []() {
+            uint64_t h = utils::shadercache::FnvOffsetBasis;
+            try {
+                std::vector<std::filesystem::path> sources;
+                for (const auto& entry : std::filesystem::directory_iterator(dllHome / "shaders")) {
+                    const auto extension = entry.path().extension();
+                    if (extension == ".hlsl" || extension == ".hlsli" || extension == ".h") {
+                        sources.push_back(entry.path());
+                    }
+                }
+                std::sort(sources.begin(), sources.end());
+                for (const auto& source : sources) {
+                    std::ifstream in(source, std::ios::binary);
+                    const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                    h = utils::shadercache::hashString(source.filename().string(), h);
+                    h = utils::shadercache::hashString(content, h);
                 }
-                FreeLibrary(d3dCompiler);
+
+                wchar_t systemDir[MAX_PATH]{};
+                GetSystemDirectoryW(systemDir, MAX_PATH);
+                for (const auto& compiler : {std::filesystem::path(systemDir) / L"d3dcompiler_47.dll",
+                                             dllHome / L"d3dcompiler_47.dll"}) {
+                    if (std::filesystem::exists(compiler)) {
+                        const uint64_t size = std::filesystem::file_size(compiler);
+                        const auto writeTime = std::filesystem::last_write_time(compiler).time_since_epoch().count();
+                        h = utils::shadercache::hashString(compiler.string(), h);
+                        h = utils::shadercache::hash(&size, sizeof(size), h);
+                        h = utils::shadercache::hash(&writeTime, sizeof(writeTime), h);
+                        break;
+                    }
+                }
+            } catch (...) {
             }
-            if (!s->levelsCS) {
-                ErrorLog("Levels shader missing or failed; levels disabled\n");
-                s->levelsEnabled = false;
-            } else {
-                D3D11_BUFFER_DESC bd{}; bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER; bd.ByteWidth = 32; bd.Usage = D3D11_USAGE_DYNAMIC; bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-                d3d->CreateBuffer(&bd, nullptr, s->levelsCB.ReleaseAndGetAddressOf());
+            return h;
+        }();
+        return sourcesHash;
+    }
+
+    // The compiled permutations of all passes, persisted in %LOCALAPPDATA%. The cache is shared by all sessions and
+    // their worker threads.
+    struct SharedShaderCache {
+        explicit SharedShaderCache(const std::filesystem::path& path) {
+            cache.open(path);
+        }
+
+        std::mutex mutex;
+        utils::shadercache::ShaderCache cache;
+
+        // Whether permutations were stored since the last flush.
+        bool dirty{false};
+    };
+
+    static SharedShaderCache& getShaderCache() {
+        static SharedShaderCache shared(localAppData / "shaders.cache");
+        return shared;
+    }
+
+    // Write the permutations compiled since the last flush to the cache file. Each flush rewrites the whole file, so it
+    // is only done once a batch of builds is over (the warm-up of a session or a swapchain, or a permutation requested
+    // by a frame), on the worker thread.
+    static void flushShaderCache() {
+        SharedShaderCache& shared = getShaderCache();
+        std::unique_lock lock(shared.mutex);
+        if (shared.dirty) {
+            shared.cache.flush();
+            shared.dirty = false;
+        }
+    }
+
+    static const char* getShaderName(ShaderPass pass) {
+        static const char* const names[] = {"CAS", "FakeHDR", "Levels"};
+        return names[(uint32_t)pass];
+    }
+
+    // The DXBC bytecode of a permutation, which both APIs accept. The embedded bytecode is referenced in place. The
+    // bytecode compiled at runtime is held, and the one read from the shader cache is copied, since flush() remaps the
+    // cache.
+    struct ShaderBytecode {
+        const void* data{nullptr};
+        size_t size{0};
+        Microsoft::WRL::ComPtr<ID3DBlob> compiled;
+        std::vector<uint8_t> cached;
+
+        bool empty() const {
+            return size == 0;
+        }
+    };
+
+    // Return the bytecode of a permutation. Empty on failure.
+    static ShaderBytecode getShaderBytecode(ShaderPass pass, const ShaderPermutation& permutation) {
+        const std::string name = getShaderName(pass);
+
+        // Use the bytecode embedded at build time (see shaders/shader_generator.py).
+        const uint32_t key = makeShaderKey(pass, permutation);
+        const shaders::EmbeddedShader* const embeddedEnd = shaders::EmbeddedShaders + shaders::EmbeddedShaderCount;
+        const shaders::EmbeddedShader* embedded = std::lower_bound(
+            shaders::EmbeddedShaders, embeddedEnd, key, [](const shaders::EmbeddedShader& entry, uint32_t value) {
+                return entry.key < value;
+            });
+        ShaderBytecode bytecode;
+        if (embedded != embeddedEnd && embedded->key == key) {
+            bytecode.data = embedded->bytecode;
+            bytecode.size = embedded->size;
+            return bytecode;
+        }
+
+        // Otherwise (the build had no fxc.exe), compile at runtime. Compile options are part of the cache key.
+        const std::string storeModeValue = std::to_string((uint32_t)permutation.storeMode);
+        const std::string encodingValue = std::to_string((uint32_t)permutation.encoding);
+        const std::string outputEncodingValue = std::to_string((uint32_t)permutation.outputEncoding);
+        const D3D_SHADER_MACRO defines[] = {{"STORE_MODE", storeModeValue.c_str()},
+                                            {"COLOR_ENCODING", encodingValue.c_str()},
+                                            {"OUTPUT_ENCODING", outputEncodingValue.c_str()},
+                                            {"CAS_SCALING", permutation.scaling ? "1" : "0"},
+                                            {nullptr, nullptr}};
+        const UINT flags = D3DCOMPILE_OPTIMIZATION_LEVEL3;
+        uint64_t cacheKey = utils::shadercache::hashString(name, getShaderSourcesHash());
+        for (const auto& define : defines) {
+            if (define.Name) {
+                cacheKey = utils::shadercache::hashString(define.Name, cacheKey);
+                cacheKey = utils::shadercache::hashString(define.Definition, cacheKey);
+            }
+        }
+        cacheKey = utils::shadercache::hash(&flags, sizeof(flags), cacheKey);
+
+        // Try the shader cache first.
+        SharedShaderCache& shared = getShaderCache();
+        {
+            std::unique_lock lock(shared.mutex);
+            const utils::shadercache::Blob cached = shared.cache.find(cacheKey);
+            if (cached.data) {
+                DebugLog(fmt::format("{} shader loaded from cache (key {:016x})\n", name, cacheKey));
+                const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(cached.data);
+                bytecode.cached.assign(bytes, bytes + cached.size);
+                bytecode.data = bytecode.cached.data();
+                bytecode.size = bytecode.cached.size();
+                return bytecode;
             }
         }
 
-        // Create FakeHDR shader if enabled
-        if (s->fakeHdrEnabled && !s->fakeHdrCS) {
-            HMODULE d3dCompiler = LoadLibraryW(L"d3dcompiler_47.dll");
-            std::wstring shaderPathW = (dllHome / L"shaders" / L"FakeHDR.hlsl").wstring();
-            Microsoft::WRL::ComPtr<ID3DBlob> blob, err;
-            if (d3dCompiler) {
-                auto pD3DCompileFromFile = reinterpret_cast<HRESULT(WINAPI*)(LPCWSTR, const D3D_SHADER_MACRO*, ID3DInclude*, LPCSTR, LPCSTR, UINT, UINT, ID3DBlob**, ID3DBlob**)>(GetProcAddress(d3dCompiler, "D3DCompileFromFile"));
-                if (pD3DCompileFromFile && SUCCEEDED(pD3DCompileFromFile(shaderPathW.c_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, "mainCS", "cs_5_0", 0, 0, blob.ReleaseAndGetAddressOf(), err.ReleaseAndGetAddressOf()))) {
-                    d3d->CreateComputeShader(blob->GetBufferPointer(), blob->GetBufferSize(), nullptr, s->fakeHdrCS.ReleaseAndGetAddressOf());
-                    Log("FakeHDR shader compiled\n");
-                }
-                FreeLibrary(d3dCompiler);
+        // Fallback: compile the permutation from HLSL
+        auto pD3DCompileFromFile = getD3DCompileFromFile();
+        if (!pD3DCompileFromFile) {
+            return {};
+        }
+        const auto shaderPath = dllHome / "shaders" / (name + ".hlsl");
+        Microsoft::WRL::ComPtr<ID3DBlob> blob, err;
+        if (FAILED(pD3DCompileFromFile(shaderPath.wstring().c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, "mainCS", "cs_5_0", flags, 0, blob.ReleaseAndGetAddressOf(), err.ReleaseAndGetAddressOf()))) {
+            std::string errMsg;
+            if (err) errMsg.assign((const char*)err->GetBufferPointer(), err->GetBufferSize());
+            ErrorLog(fmt::format("Failed to compile {}.hlsl: {}\n{}\n", name, shaderPath.string(), errMsg));
+            return {};
+        }
+        Log(fmt::format("{} shader compiled: {} (store mode {}, encoding {}, output encoding {}, scaling {})\n",
+                        name,
+                        shaderPath.string(),
+                        storeModeValue,
+                        encodingValue,
+                        outputEncodingValue,
+                        permutation.scaling ? 1 : 0));
+        {
+            std::unique_lock lock(shared.mutex);
+            shared.cache.store(cacheKey, blob->GetBufferPointer(), blob->GetBufferSize());
+            shared.dirty = true;
+        }
+        bytecode.data = blob->GetBufferPointer();
+        bytecode.size = blob->GetBufferSize();
+        bytecode.compiled = std::move(blob);
+        return bytecode;
+    }
+
+    static Microsoft::WRL::ComPtr<ID3D11ComputeShader> createShader(ID3D11Device* d3d,
+                                                                    ShaderPass pass,
+                                                                    const ShaderPermutation& permutation) {
+        const ShaderBytecode bytecode = getShaderBytecode(pass, permutation);
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader> shader;
+        if (!bytecode.empty() &&
+            FAILED(d3d->CreateComputeShader(bytecode.data, bytecode.size, nullptr, shader.ReleaseAndGetAddressOf()))) {
+            ErrorLog(fmt::format("Failed to create {} shader (key {:08x})\n",
+                                 getShaderName(pass),
+                                 makeShaderKey(pass, permutation)));
+        }
+        return shader;
+    }
+
+    static Microsoft::WRL::ComPtr<ID3D12PipelineState> createPipeline(SessionState* s,
+                                                                      ShaderPass pass,
+                                                                      const ShaderPermutation& permutation) {
+        const ShaderBytecode bytecode = getShaderBytecode(pass, permutation);
+        if (bytecode.empty()) {
+            return nullptr;
+        }
+        const std::string name = getShaderName(pass);
+        auto pipeline = s->d3d12->createPipeline(
+            bytecode.data, bytecode.size, std::wstring(name.begin(), name.end()).c_str());
+        if (!pipeline) {
+            ErrorLog(fmt::format("Failed to create {} pipeline (key {:08x})\n", name, makeShaderKey(pass, permutation)));
+        }
+        return pipeline;
+    }
+
+    // Return a permutation of a pass, building it on first use. This blocks, it is meant for the worker thread.
+    static ID3D11ComputeShader* getShader(SessionState* s, ShaderPass pass, const ShaderPermutation& permutation) {
+        const uint32_t key = makeShaderKey(pass, permutation);
+        {
+            std::unique_lock lock(s->objectsMutex);
+            auto it = s->shaders.find(key);
+            if (it != s->shaders.end()) {
+                return it->second.Get();
             }
-            if (!s->fakeHdrCS) {
-                ErrorLog("FakeHDR shader missing or failed; fakehdr disabled\n");
-                s->fakeHdrEnabled = false;
-            } else {
-                D3D11_BUFFER_DESC bd{}; bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER; bd.ByteWidth = 32; bd.Usage = D3D11_USAGE_DYNAMIC; bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-                d3d->CreateBuffer(&bd, nullptr, s->fakeHdrCB.ReleaseAndGetAddressOf());
+        }
+        auto shader = createShader(s->appD3DDevice.Get(), pass, permutation);
+        std::unique_lock lock(s->objectsMutex);
+        s->pendingShaders.erase(key);
+        return s->shaders.insert_or_assign(key, std::move(shader)).first->second.Get();
+    }
+
+    // Return a permutation of a pass without blocking the frame: a permutation that is not built yet is queued on the
+    // worker thread and nullopt is returned. A permutation that failed to build is returned as nullptr.
+    static std::optional<ID3D11ComputeShader*> requestShader(SessionState* s,
+                                                            ShaderPass pass,
+                                                            const ShaderPermutation& permutation) {
+        if (!s->worker) {
+            return getShader(s, pass, permutation);
+        }
+        const uint32_t key = makeShaderKey(pass, permutation);
+        std::unique_lock lock(s->objectsMutex);
+        auto it = s->shaders.find(key);
+        if (it != s->shaders.end()) {
+            return it->second.Get();
+        }
+        if (s->pendingShaders.insert(key).second) {
+            s->worker->post([s, pass, permutation]() {
+                getShader(s, pass, permutation);
+                flushShaderCache();
+            });
+        }
+        return std::nullopt;
+    }
+
+    // getShader() and requestShader() for D3D12 sessions. D3D12 devices are free-threaded, so there is always a worker.
+    static ID3D12PipelineState* getPipeline(SessionState* s, ShaderPass pass, const ShaderPermutation& permutation) {
+        const uint32_t key = makeShaderKey(pass, permutation);
+        {
+            std::unique_lock lock(s->objectsMutex);
+            auto it = s->pipelines.find(key);
+            if (it != s->pipelines.end()) {
+                return it->second.Get();
             }
         }
+        auto pipeline = createPipeline(s, pass, permutation);
+        std::unique_lock lock(s->objectsMutex);
+        s->pendingShaders.erase(key);
+        return s->pipelines.insert_or_assign(key, std::move(pipeline)).first->second.Get();
+    }
 
-        // Constant buffer (2x uint4)
-        D3D11_BUFFER_DESC bd{};
-        bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        bd.ByteWidth = 2 * sizeof(uint32_t[4]);
-        bd.Usage = D3D11_USAGE_DYNAMIC;
-        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-        if (FAILED(d3d->CreateBuffer(&bd, nullptr, s->constCB.ReleaseAndGetAddressOf()))) {
-            ErrorLog("CAS: failed to create const buffer\n");
-            return false;
+    static std::optional<ID3D12PipelineState*> requestPipeline(SessionState* s,
+                                                              ShaderPass pass,
+                                                              const ShaderPermutation& permutation) {
+        const uint32_t key = makeShaderKey(pass, permutation);
+        std::unique_lock lock(s->objectsMutex);
+        auto it = s->pipelines.find(key);
+        if (it != s->pipelines.end()) {
+            return it->second.Get();
+        }
+        if (s->pendingShaders.insert(key).second) {
+            s->worker->post([s, pass, permutation]() {
+                getPipeline(s, pass, permutation);
+                flushShaderCache();
+            });
         }
-        // Debug CB: one uint (must be 16-byte aligned for D3D11 constant buffers)
-        D3D11_BUFFER_DESC bd2{};
-        bd2.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        bd2.ByteWidth = 32;
-        bd2.Usage = D3D11_USAGE_DYNAMIC;
-        bd2.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-        if (FAILED(d3d->CreateBuffer(&bd2, nullptr, s->debugCB.ReleaseAndGetAddressOf()))) {
-            ErrorLog("CAS: failed to create debug buffer\n");
+        return std::nullopt;
+    }
+
+    // Build a permutation for whichever API the session uses. Blocks, like getShader().
+    static bool buildPass(SessionState* s, ShaderPass pass, const ShaderPermutation& permutation) {
+        return s->d3d12 ? getPipeline(s, pass, permutation) != nullptr : getShader(s, pass, permutation) != nullptr;
+    }
+
+    // Return how to write a format on this device, querying it on first use.
+    static std::optional<utils::formats::StorePlan> getStorePlan(SessionState* s,
+                                                                 const utils::formats::FormatInfo& formatInfo) {
+        std::unique_lock lock(s->objectsMutex);
+        auto planIt = s->storePlans.find(formatInfo.format);
+        if (planIt == s->storePlans.end()) {
+            const auto plan = s->d3d12 ? utils::formats::chooseStorePlan(s->d3d12->getDevice(), formatInfo)
+                                       : utils::formats::chooseStorePlan(s->appD3DDevice.Get(), formatInfo);
+            if (!plan) {
+                ErrorLog(fmt::format("CAS: no UAV store support for format {} on this device\n", (int)formatInfo.format));
+            } else if (plan->storeMode != utils::formats::StoreMode::Typed) {
+                Log(fmt::format("CAS: no typed UAV store for format {}, using packed stores\n", (int)formatInfo.format));
+            }
+            planIt = s->storePlans.emplace(formatInfo.format, plan).first;
+        }
+        return planIt->second;
+    }
+
+    // The permutation used for a swapchain format.
+    static ShaderPermutation getPermutation(SessionState* s,
+                                            const utils::formats::FormatInfo& formatInfo,
+                                            const utils::formats::StorePlan& storePlan) {
+        ShaderPermutation permutation;
+        permutation.storeMode = storePlan.storeMode;
+        if (formatInfo.isSRGB) {
+            permutation.encoding =
+                s->srgbExact ? utils::formats::ColorEncoding::SRGBExact : utils::formats::ColorEncoding::SRGBFast;
+        }
+        permutation.outputEncoding = permutation.encoding;
+        return permutation;
+    }
+
+    // The permutation of the last pass of a chain when the destination has another format: it reads like the other
+    // passes, but encodes and stores for the destination format.
+    static ShaderPermutation getConversionPermutation(SessionState* s,
+                                                      const ShaderPermutation& permutation,
+                                                      const utils::formats::FormatInfo& destinationFormatInfo,
+                                                      const utils::formats::StorePlan& destinationStorePlan) {
+        ShaderPermutation conversion = getPermutation(s, destinationFormatInfo, destinationStorePlan);
+        conversion.encoding = permutation.encoding;
+        conversion.scaling = permutation.scaling;
+        return conversion;
+    }
+
+    // Create the shaders and queries shared by all swapchains. Runs on the worker thread unless the device is
+    // single-threaded.
+    static bool ensureCasObjects(SessionState* s) {
+        if (!s || (!s->appD3DDevice && !s->d3d12)) return false;
+        if (s->shaderInitAttempted) return !s->shaderInitFailed;
+        s->shaderInitAttempted = true;
+
+        // Build the default permutations upfront, so that a missing shader disables its pass. Other permutations are
+        // built on first use.
+        if (!buildPass(s, ShaderPass::Cas, {})) {
+            ErrorLog("CAS shader missing or failed; CAS disabled\n");
+            s->shaderInitFailed = true;
             return false;
         }
+        if (s->levelsEnabled && !buildPass(s, ShaderPass::Levels, {})) {
+            ErrorLog("Levels shader missing or failed; levels disabled\n");
+            s->levelsEnabled = false;
+        }
+        if (s->fakeHdrEnabled && !buildPass(s, ShaderPass::FakeHdr, {})) {
+            ErrorLog("FakeHDR shader missing or failed; fakehdr disabled\n");
+            s->fakeHdrEnabled = false;
+        }
 
-        // Create timestamp queries
-        if (!s->qDisjoint) {
+        // Create timestamp queries. The D3D12 backend has its own.
+        if (s->appD3DDevice && !s->qDisjoint) {
+            ID3D11Device* d3d = s->appD3DDevice.Get();
             D3D11_QUERY_DESC qd{}; qd.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
             d3d->CreateQuery(&qd, s->qDisjoint.ReleaseAndGetAddressOf());
             qd.Query = D3D11_QUERY_TIMESTAMP;
-            d3d->CreateQuery(&qd, s->qBegin.ReleaseAndGetAddressOf());
-            d3d->CreateQuery(&qd, s->qEnd.ReleaseAndGetAddressOf());
+            for (auto& query : s->qTimestamps) {
+                if (FAILED(d3d->CreateQuery(&qd, query.ReleaseAndGetAddressOf()))) {
+                    s->qDisjoint.Reset();
+                }
+            }
         }
         return true;
     }
 
-    static uint64_t makeTempKey(XrSwapchain swapchain, uint32_t arraySlice) {
-        return (uint64_t)swapchain ^ (uint64_t(arraySlice) << 32);
+    // Temporary textures are pooled by size bucket and resource format, across swapchains and views (see
+    // utils::texturepool). Multisampled sources need the exact size, as the target of the resolve.
+    static utils::texturepool::Key
+    makeTempKey(UINT width, UINT height, DXGI_FORMAT resourceFormat, bool exact = false) {
+        const uint32_t granularity = exact ? 1 : utils::texturepool::BucketGranularity;
+        return utils::texturepool::makeKey(width, height, resourceFormat, granularity);
     }
 
-    struct TempTextures { Microsoft::WRL::ComPtr<ID3D11Texture2D> input; Microsoft::WRL::ComPtr<ID3D11Texture2D> output; UINT width{}, height{}; DXGI_FORMAT format{}; };
+    // The video memory of a pair of temporary textures.
+    static uint64_t getTempTexturesBytes(const utils::texturepool::Key& key) {
+        const DXGI_FORMAT format = (DXGI_FORMAT)key.format;
+        const uint64_t bytesPerPixel =
+            format == DXGI_FORMAT_R16G16B16A16_TYPELESS || format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+        return 2 * bytesPerPixel * key.width * key.height;
+    }
+
+    // Count the outcome of a pool acquisition. Returns false if the pool is over its cap.
+    template <typename Textures>
+    static bool countPoolAcquire(const Textures* textures, bool created) {
+        using utils::telemetry::Event;
+        utils::telemetry::increment(!textures  ? Event::PoolExhausted
+                                    : created ? Event::PoolAllocation
+                                              : Event::PoolHit);
+        return textures != nullptr;
+    }
+
+    // The constant buffers of a swapchain slice, one per pass. CAS upscaling uses separate buffers for its first pass,
+    // so that neither set is rewritten within a frame.
+    enum class ConstantsSlot : uint32_t { Cas = 0, CasRect, CasScaling, CasScalingRect, FakeHdr, Levels, Count };
+
+    static utils::constants::Key makeConstantsKey(XrSwapchain swapchain, uint32_t arraySlice, ConstantsSlot slot) {
+        return {(uint64_t)swapchain, arraySlice, (uint32_t)slot};
+    }
+
+    // (Re)create a pair of single-slice temporary textures with SRV+UAV binding, unless they already match.
+    static bool ensureTempTextures(ID3D11Device* d3d,
+                                   TempTextures& slot,
+                                   const D3D11_TEXTURE2D_DESC& desc,
+                                   UINT width,
+                                   UINT height,
+                                   DXGI_FORMAT resourceFormat) {
+        if (slot.input && slot.width == width && slot.height == height && slot.format == desc.Format) {
+            return true;
+        }
+        D3D11_TEXTURE2D_DESC texDesc = desc;
+        texDesc.Width = width;
+        texDesc.Height = height;
+        texDesc.MiscFlags = 0;
+        texDesc.CPUAccessFlags = 0;
+        texDesc.Usage = D3D11_USAGE_DEFAULT;
+        texDesc.ArraySize = 1; // create single-slice 2D textures to match shader resource type
+        texDesc.MipLevels = 1;
+        texDesc.SampleDesc = {1, 0}; // also the resolve target for multisampled sources
+        // Choose a resource format that allows both SRV and UAV views. Use typeless when needed.
+        texDesc.Format = resourceFormat;
+        // Input: SRV+UAV (for ping-pong passes and Levels)
+        texDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+        if (FAILED(d3d->CreateTexture2D(&texDesc, nullptr, slot.input.ReleaseAndGetAddressOf()))) {
+            ErrorLog("CAS: CreateTexture2D input failed\n");
+            return false;
+        }
+        // Output: UAV+SRV
+        texDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+        if (FAILED(d3d->CreateTexture2D(&texDesc, nullptr, slot.output.ReleaseAndGetAddressOf()))) {
+            ErrorLog("CAS: CreateTexture2D output failed\n");
+            return false;
+        }
+        slot.width = width; slot.height = height; slot.format = desc.Format;
+        return true;
+    }
+
+    // Acquire a pair of temporary textures for the key from the pool, creating them if needed. The pair must be
+    // released once the passes are recorded.
+    static TempTextures* acquireTempTextures(utils::texturepool::Pool<TempTextures>& pool,
+                                             ID3D11Device* d3d,
+                                             const D3D11_TEXTURE2D_DESC& desc,
+                                             const utils::texturepool::Key& key,
+                                             uint32_t& id) {
+        bool created = false;
+        TempTextures* textures = pool.acquire(key, getTempTexturesBytes(key), id, created);
+        if (!countPoolAcquire(textures, created)) {
+            return nullptr;
+        }
+        if (created && !ensureTempTextures(d3d, *textures, desc, key.width, key.height, (DXGI_FORMAT)key.format)) {
+            pool.discard(id);
+            return nullptr;
+        }
+        return textures;
+    }
+
+    // Map a rect of an application image to the upscaled image. Each edge is rounded separately, so that adjacent
+    // rects stay adjacent.
+    static XrRect2Di scaleRect(const XrRect2Di& rect, float scaleX, float scaleY) {
+        const int32_t left = (int32_t)std::lround(rect.offset.x * scaleX);
+        const int32_t top = (int32_t)std::lround(rect.offset.y * scaleY);
+        const int32_t right = (int32_t)std::lround((rect.offset.x + rect.extent.width) * scaleX);
+        const int32_t bottom = (int32_t)std::lround((rect.offset.y + rect.extent.height) * scaleY);
+        return {{left, top}, {right - left, bottom - top}};
+    }
+
+    // A layer-owned swapchain receiving the processed image when it cannot be written back to the application
+    // swapchain: the application swapchain is multisampled, or the image is upscaled.
+    struct OutputTarget {
+        std::shared_ptr<utils::graphics::ISwapchain> swapchain;
+        utils::graphics::ISwapchainImage* acquiredImage{nullptr};
+
+        // Resolution of the swapchain: the native resolution, ie: the application swapchain resolution multiplied by
+        // its native scale. It does not follow the dynamic resolution.
+        uint32_t width{0};
+        uint32_t height{0};
+        float nativeScale{1.0f};
+
+        // Whether the swapchain replaces the application swapchain in the current frame.
+        bool submit{false};
+
+        // Whether acquiring an image failed in the current frame. The remaining views are not processed either, since
+        // the swapchain is not submitted.
+        bool acquireFailed{false};
+    };
+
+    // A view of a projection layer of the current frame, and where it goes in the output swapchain.
+    struct ViewOutput {
+        XrSwapchain swapchain{XR_NULL_HANDLE};
+        uint32_t arraySlice{0};
+
+        // The rect of the view, clipped to the image. Empty when the view is not processed.
+        XrRect2Di rect{};
 
-    static void dispatchCas(SessionState* s, XrSwapchain swapchain, ID3D11Texture2D* source, const XrSwapchainSubImage& sub,
-                            std::unordered_map<uint64_t, TempTextures>& tempPool) {
-        if (!ensureCasObjects(s)) return;
+        // Ratio of the native resolution of the view to the rect rendered by the application, per axis. The
+        // application may render at the recommended resolution or not, so the ratio is measured every frame.
+        float scaleX{1.0f};
+        float scaleY{1.0f};
+
+        // The rect in the output swapchain, only valid once the output swapchain was acquired.
+        XrRect2Di outputRect{};
+
+        bool isUpscaled() const {
+            return scaleX > 1.0f || scaleY > 1.0f;
+        }
+    };
+
+    // Bind the CAS constants for a pass reading inRect of its input and writing outRect of its output. The buffers are
+    // only written (and CasSetup() only runs) when the strength or the rects change.
+    static bool bindCasConstants(SessionState* s,
+                                 XrSwapchain swapchain,
+                                 uint32_t arraySlice,
+                                 bool scaling,
+                                 float casStrength,
+                                 const XrRect2Di& inRect,
+                                 const XrRect2Di& outRect) {
+        ID3D11Device* d3d = s->appD3DDevice.Get();
+        ID3D11DeviceContext* ctx = s->appD3DContext.Get();
+
+        const utils::constants::Key casKey =
+            makeConstantsKey(swapchain, arraySlice, scaling ? ConstantsSlot::CasScaling : ConstantsSlot::Cas);
+        struct {
+            float strength;
+            int32_t inWidth, inHeight, outWidth, outHeight;
+        } params{casStrength, inRect.extent.width, inRect.extent.height, outRect.extent.width, outRect.extent.height};
+        ID3D11Buffer* cb = s->constants.find(casKey, &params, sizeof(params));
+        if (!cb) {
+            uint32_t consts[8]{};
+            CasSetup(consts,
+                     consts + 4,
+                     casStrength,
+                     (float)inRect.extent.width,
+                     (float)inRect.extent.height,
+                     (float)outRect.extent.width,
+                     (float)outRect.extent.height);
+            cb = s->constants.put(d3d, ctx, casKey, &params, sizeof(params), consts, sizeof(consts));
+        }
+
+        // Debug/rect CB: flags (debug overlay disabled in production) + output rect + input offset
+        struct DebugCB { UINT flags, offx, offy, extx; UINT exty, inx, iny, pad3; } cbData{};
+        cbData.offx = outRect.offset.x;
+        cbData.offy = outRect.offset.y;
+        cbData.extx = outRect.extent.width;
+        cbData.exty = outRect.extent.height;
+        cbData.inx = inRect.offset.x;
+        cbData.iny = inRect.offset.y;
+        ID3D11Buffer* cbDebug = s->constants.update(
+            d3d,
+            ctx,
+            makeConstantsKey(swapchain, arraySlice, scaling ? ConstantsSlot::CasScalingRect : ConstantsSlot::CasRect),
+            &cbData,
+            sizeof(cbData));
+        if (!cb || !cbDebug) {
+            return false;
+        }
+
+        utils::recorder::Handle cbs[2] = {cb, cbDebug};
+        s->recorder->setConstantBuffers(0, 2, cbs);
+        return true;
+    }
+
+    // Update the averages with the timestamps of a dispatch, one per stage boundary (see utils::stats::GpuStage).
+    static void accumulateGpuTimings(SessionState* s, const uint64_t* timestamps, double frequency) {
+        for (uint32_t i = 0; i < (uint32_t)utils::stats::GpuStage::Count; i++) {
+            const float ms = (float)(double(timestamps[i + 1] - timestamps[i]) / frequency * 1000.0);
+            float& average = s->stats.gpuMs[i];
+            average = average > 0.0f ? average + 0.1f * (ms - average) : ms;
+        }
+
+        s->timingAccumMs += double(timestamps[1] - timestamps[0]) / frequency * 1000.0;
+        if (++s->timingFrameCounter >= 120) {
+            if (s->recorder) {
+                const auto& bindStats = s->recorder->getStats();
+                Log(fmt::format("CAS average GPU cost: {:.3f} ms, binds issued {} elided {}, state "
+                                "save/restore {:.3f} ms\n",
+                                s->timingAccumMs / s->timingFrameCounter,
+                                bindStats.issued,
+                                bindStats.elided(),
+                                s->stateRestoreCounter ? s->stateRestoreAccumMs / s->stateRestoreCounter : 0.0));
+                s->recorder->resetStats();
+            } else {
+                Log(fmt::format("CAS average GPU cost: {:.3f} ms\n", s->timingAccumMs / s->timingFrameCounter));
+            }
+            s->stateRestoreAccumMs = 0.0; s->stateRestoreCounter = 0;
+            s->timingAccumMs = 0.0; s->timingFrameCounter = 0;
+        }
+    }
+
+    // Read back the timestamps of an earlier dispatch if the GPU is done with them, and update the averages.
+    static void collectGpuTimings(SessionState* s) {
+        if (!s->timingPending) {
+            return;
+        }
+        ID3D11DeviceContext* ctx = s->appD3DContext.Get();
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+        if (ctx->GetData(s->qDisjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+            return;
+        }
+        s->timingPending = false;
+        UINT64 timestamps[(uint32_t)utils::stats::GpuStage::Count + 1]{};
+        for (uint32_t i = 0; i < std::size(timestamps); i++) {
+            if (ctx->GetData(s->qTimestamps[i].Get(), &timestamps[i], sizeof(UINT64), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+                return;
+            }
+        }
+        if (disjoint.Disjoint) {
+            return;
+        }
+        accumulateGpuTimings(s, timestamps, double(disjoint.Frequency));
+    }
+
+    // Set the application's compute state aside before the layer's passes. The CPU time spent here and in
+    // restoreApplicationState() is reported with the GPU timings.
+    static void saveApplicationState(SessionState* s) {
+        const auto start = std::chrono::steady_clock::now();
+        ID3D11DeviceContext* ctx = s->appD3DContext.Get();
+        switch (s->stateRestore) {
+        case SessionState::StateRestore::Targeted:
+            s->appComputeState.capture(ctx);
+            break;
+        case SessionState::StateRestore::ContextState: {
+            Microsoft::WRL::ComPtr<ID3D11DeviceContext1> ctx1;
+            if (SUCCEEDED(ctx->QueryInterface(ctx1.ReleaseAndGetAddressOf()))) {
+                ctx1->SwapDeviceContextState(s->layerContextState.Get(), s->appContextState.ReleaseAndGetAddressOf());
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        // Whatever the recorder believed is bound no longer holds.
+        s->recorder->invalidate();
+        s->stateRestoreAccumMs +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static void restoreApplicationState(SessionState* s) {
+        const auto start = std::chrono::steady_clock::now();
+        ID3D11DeviceContext* ctx = s->appD3DContext.Get();
+        switch (s->stateRestore) {
+        case SessionState::StateRestore::Targeted:
+            s->appComputeState.restore(ctx);
+            break;
+        case SessionState::StateRestore::ContextState:
+            if (s->appContextState) {
+                Microsoft::WRL::ComPtr<ID3D11DeviceContext1> ctx1;
+                ctx->QueryInterface(ctx1.ReleaseAndGetAddressOf());
+                ctx1->SwapDeviceContextState(s->appContextState.Get(), nullptr);
+                s->appContextState.Reset();
+            }
+            break;
+        default:
+            break;
+        }
+        s->recorder->invalidate();
+        s->stateRestoreAccumMs +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        s->stateRestoreCounter++;
+    }
+
+    // Prepare what the first frames of a new swapchain need: the permutations for its format and its temporary textures.
+    // Runs on the worker thread.
+    static void warmUpSwapchain(SessionState* s,
+                                XrSwapchain swapchain,
+                                const XrSwapchainCreateInfo& createInfo,
+                                bool upscaling) {
+        const utils::formats::FormatInfo* formatInfo = utils::formats::getFormatInfo((DXGI_FORMAT)createInfo.format);
+        if (!formatInfo || !(createInfo.usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT)) {
+            return;
+        }
+        const auto plan = getStorePlan(s, *formatInfo);
+        if (!plan) {
+            return;
+        }
+        const ShaderPermutation permutation = getPermutation(s, *formatInfo, *plan);
+        buildPass(s, ShaderPass::Cas, permutation);
+        if (upscaling) {
+            ShaderPermutation scalingPermutation = permutation;
+            scalingPermutation.scaling = true;
+            buildPass(s, ShaderPass::Cas, scalingPermutation);
+        }
+        if (s->fakeHdrEnabled) {
+            buildPass(s, ShaderPass::FakeHdr, permutation);
+        }
+        if (s->levelsEnabled) {
+            buildPass(s, ShaderPass::Levels, permutation);
+        }
+        flushShaderCache();
+        if (s->d3d12) {
+            // The D3D12 temporary textures belong to the backend, which is only used on the application's thread.
+            return;
+        }
+
+        // The source resolution pair, shared by all slices. The output resolution pair depends on the scale at the
+        // time of the frame and is left to dispatchCas().
+        D3D11_TEXTURE2D_DESC desc{};
+        desc.Format = formatInfo->format;
+        SessionState::WarmTextures entry{
+            makeTempKey(createInfo.width, createInfo.height, formatInfo->resourceFormat, createInfo.sampleCount > 1),
+            {}};
+        if (!ensureTempTextures(s->appD3DDevice.Get(),
+                                entry.textures,
+                                desc,
+                                entry.key.width,
+                                entry.key.height,
+                                formatInfo->resourceFormat)) {
+            return;
+        }
+        std::unique_lock lock(s->objectsMutex);
+        s->warmTextures.push_back(std::move(entry));
+    }
+
+    // Tags of the passes of the post-processing graph.
+    enum class GraphPass : uint32_t { CopyIn = 0, CasScaling, Cas, FakeHdr, Levels, CopyOut };
+
+    // The stage a pass is timed in (see utils::stats::GpuStage), Count for the copy out.
+    static uint32_t getGpuStage(GraphPass pass) {
+        switch (pass) {
+        case GraphPass::FakeHdr:
+            return (uint32_t)utils::stats::GpuStage::FakeHdr;
+        case GraphPass::Levels:
+            return (uint32_t)utils::stats::GpuStage::Levels;
+        case GraphPass::CopyOut:
+            return (uint32_t)utils::stats::GpuStage::Count;
+        default:
+            return (uint32_t)utils::stats::GpuStage::Cas;
+        }
+    }
+
+    static const char* getGraphPassName(GraphPass pass) {
+        switch (pass) {
+        case GraphPass::CopyIn:
+            return "CopyIn";
+        case GraphPass::FakeHdr:
+            return "FakeHDR";
+        case GraphPass::Levels:
+            return "Levels";
+        case GraphPass::CopyOut:
+            return "CopyOut";
+        default:
+            return "CAS";
+        }
+    }
+
+    // Size class of the output of the last compute pass when it converts to the destination format.
+    constexpr uint32_t ConversionSizeClass = 2;
+
+    // Declare the chain of a view: copy in, the CAS passes (the first one upscales when upscaling), FakeHDR, Levels and
+    // copy out. The source and destination are imported in that order. Size class 0 is the source resolution and 1
+    // the output resolution, only used when upscaling. When converting, the last compute pass writes to
+    // ConversionSizeClass instead, in the destination format.
+    static bool buildPassGraph(utils::passgraph::PassGraph& graph,
+                               int casPasses,
+                               bool upscaling,
+                               bool fakeHdr,
+                               bool levels,
+                               bool converting) {
+        using utils::passgraph::PassKind;
+        const uint32_t outputClass = upscaling ? 1 : 0;
+        graph.reset();
+        const auto source = graph.importTexture();
+        const auto destination = graph.importTexture();
+        auto current = graph.createTransient(0);
+        graph.addPass((uint32_t)GraphPass::CopyIn, PassKind::Copy, source, current);
+        int remainingPasses = casPasses + (fakeHdr ? 1 : 0) + (levels ? 1 : 0);
+        const auto addCompute = [&](GraphPass pass, bool enabled) {
+            const bool last = enabled && --remainingPasses == 0;
+            const auto next = graph.createTransient(converting && last ? ConversionSizeClass : outputClass);
+            graph.addPass((uint32_t)pass, PassKind::Compute, current, next, enabled);
+            current = next;
+        };
+        for (int pass = 0; pass < casPasses; ++pass) {
+            addCompute(upscaling && pass == 0 ? GraphPass::CasScaling : GraphPass::Cas, true);
+        }
+        addCompute(GraphPass::FakeHdr, fakeHdr);
+        addCompute(GraphPass::Levels, levels);
+        graph.addPass((uint32_t)GraphPass::CopyOut, PassKind::Copy, current, destination);
+        return graph.compile();
+    }
+
+    // Return the single-sampled copy of a slice of a multisampled image, resolving it unless it was already resolved in
+    // this frame. The whole slice is resolved, so that all the views of the slice share the copy. sRGB images are
+    // resolved through their sRGB format, which averages the samples in linear space. The copies are held until
+    // releaseResolvedSlices().
+    static ID3D11Texture2D* getResolvedSlice(SessionState* s,
+                                             utils::texturepool::Pool<TempTextures>& pool,
+                                             ID3D11Texture2D* source,
+                                             const D3D11_TEXTURE2D_DESC& desc,
+                                             uint32_t arraySlice,
+                                             const utils::formats::FormatInfo& formatInfo) {
+        for (const auto& resolved : s->resolvedSlices) {
+            if (resolved.source == source && resolved.arraySlice == arraySlice) {
+                return resolved.texture;
+            }
+        }
+
+        uint32_t id = 0;
+        const utils::texturepool::Key key = makeTempKey(desc.Width, desc.Height, formatInfo.resourceFormat, true);
+        TempTextures* const textures = acquireTempTextures(pool, s->appD3DDevice.Get(), desc, key, id);
+        if (!textures) {
+            return nullptr;
+        }
+        s->appD3DContext->ResolveSubresource(textures->input.Get(),
+                                             0,
+                                             source,
+                                             D3D11CalcSubresource(0, arraySlice, desc.MipLevels),
+                                             formatInfo.isSRGB ? formatInfo.format : formatInfo.srvFormat);
+        s->resolvedSlices.push_back({source, arraySlice, textures->input.Get(), id});
+        return textures->input.Get();
+    }
+
+    static void releaseResolvedSlices(SessionState* s, utils::texturepool::Pool<TempTextures>& pool) {
+        for (const auto& resolved : s->resolvedSlices) {
+            pool.release(resolved.poolId);
+        }
+        s->resolvedSlices.clear();
+    }
+
+    // Process a rect of one slice of source and write the result to outputRect of the same slice in destination.
+    // destination may be source itself, but it must be single-sampled: multisampled sources are resolved first. When
+    // outputRect is larger than the source rect, the first CAS pass upscales.
+    // The formats are the ones the swapchains were created with: swapchain textures are often typeless (eg: sRGB
+    // swapchains), so their description does not tell how to view them.
+    static bool dispatchCas(SessionState* s,
+                            XrSwapchain swapchain,
+                            ID3D11Texture2D* source,
+                            DXGI_FORMAT sourceFormat,
+                            ID3D11Texture2D* destination,
+                            DXGI_FORMAT destinationFormat,
+                            const XrSwapchainSubImage& sub,
+                            const XrRect2Di& outputRect,
+                            utils::texturepool::Pool<TempTextures>& pool) {
+        using utils::telemetry::Event;
+        if (!s->ready.load(std::memory_order_acquire)) {
+            utils::telemetry::increment(Event::NotReady);
+            return false;
+        }
+        utils::profiler::Scope scope("dispatchCas");
+        // The stage currently timed, each emplace() ends the previous one.
+        std::optional<utils::profiler::Scope> stage;
 
         ID3D11Device* d3d = s->appD3DDevice.Get();
         ID3D11DeviceContext* ctx = s->appD3DContext.Get();
 
         D3D11_TEXTURE2D_DESC td{};
         source->GetDesc(&td);
+        D3D11_TEXTURE2D_DESC dstDesc{};
+        destination->GetDesc(&dstDesc);
         // Only support UAV+copy-safe formats to avoid driver/device crashes
-        const bool supported =
-            td.Format == DXGI_FORMAT_R8G8B8A8_UNORM || td.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ||
-            td.Format == DXGI_FORMAT_R8G8B8A8_TYPELESS ||
-            td.Format == DXGI_FORMAT_B8G8R8A8_UNORM || td.Format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
-            td.Format == DXGI_FORMAT_B8G8R8A8_TYPELESS ||
-            td.Format == DXGI_FORMAT_B8G8R8X8_UNORM || td.Format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB ||
-            td.Format == DXGI_FORMAT_B8G8R8X8_TYPELESS ||
-            td.Format == DXGI_FORMAT_R16G16B16A16_FLOAT;
-        if (!supported) {
-            DebugLog(fmt::format("CAS: unsupported swapchain format {}. Skipping.\n", (int)td.Format));
-            return;
+        const utils::formats::FormatInfo* formatInfo = utils::formats::getFormatInfo(sourceFormat);
+        if (!formatInfo) {
+            utils::telemetry::increment(Event::UnsupportedFormat);
+            return false;
         }
-        if (td.SampleDesc.Count != 1) {
-            Log("CAS: skip MSAA swapchain image\n");
-            return; // skip MSAA
-        }
-
-        // Use pooled temporary textures per (swapchain,slice)
-        const uint64_t poolKey = makeTempKey(swapchain, sub.imageArrayIndex);
-        auto& slot = tempPool[poolKey];
-        if (!slot.input || slot.width != td.Width || slot.height != td.Height || slot.format != td.Format) {
-            D3D11_TEXTURE2D_DESC texDesc = td;
-            texDesc.MiscFlags = 0;
-            texDesc.CPUAccessFlags = 0;
-            texDesc.Usage = D3D11_USAGE_DEFAULT;
-            texDesc.ArraySize = 1; // create single-slice 2D textures to match shader resource type
-            texDesc.MipLevels = 1;
-            // Choose a resource format that allows both SRV and UAV views. Use typeless when needed.
-            auto chooseTypeless = [](DXGI_FORMAT f) {
-                switch (f) {
-                case DXGI_FORMAT_R8G8B8A8_UNORM:
-                case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
-                case DXGI_FORMAT_R8G8B8A8_TYPELESS: return DXGI_FORMAT_R8G8B8A8_TYPELESS;
-                case DXGI_FORMAT_B8G8R8A8_UNORM:
-                case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
-                case DXGI_FORMAT_B8G8R8A8_TYPELESS: return DXGI_FORMAT_B8G8R8A8_TYPELESS;
-                case DXGI_FORMAT_B8G8R8X8_UNORM:
-                case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
-                case DXGI_FORMAT_B8G8R8X8_TYPELESS: return DXGI_FORMAT_B8G8R8X8_TYPELESS;
-                default: return f; // keep as-is (eg R16G16B16A16_FLOAT)
+        const auto plan = getStorePlan(s, *formatInfo);
+        if (!plan) {
+            utils::telemetry::increment(Event::NoStorePlan);
+            return false;
+        }
+        const utils::formats::StorePlan& storePlan = plan.value();
+        const ShaderPermutation permutation = getPermutation(s, *formatInfo, storePlan);
+
+        // A destination of another format (an output swapchain in the runtime's preferred format) is converted by the
+        // last compute pass as it stores, so that the copy out stays a plain copy.
+        const utils::formats::FormatInfo* dstFormatInfo = formatInfo;
+        std::optional<utils::formats::StorePlan> dstPlan = storePlan;
+        if (destinationFormat != sourceFormat) {
+            dstFormatInfo = utils::formats::getFormatInfo(destinationFormat);
+            if (!dstFormatInfo) {
+                utils::telemetry::increment(Event::UnsupportedFormat);
+                return false;
+            }
+            dstPlan = getStorePlan(s, *dstFormatInfo);
+            if (!dstPlan) {
+                utils::telemetry::increment(Event::NoStorePlan);
+                return false;
+            }
+        }
+        const bool converting = dstFormatInfo->resourceFormat != formatInfo->resourceFormat ||
+                                dstFormatInfo->isSRGB != formatInfo->isSRGB;
+
+        // Pass frames through untouched while a permutation is being built, rather than waiting for it.
+        using ShaderRequest = std::optional<ID3D11ComputeShader*>;
+        const ShaderRequest casRequest = requestShader(s, ShaderPass::Cas, permutation);
+        const ShaderRequest fakeHdrRequest =
+            s->fakeHdrEnabled ? requestShader(s, ShaderPass::FakeHdr, permutation) : ShaderRequest(nullptr);
+        const ShaderRequest levelsRequest =
+            s->levelsEnabled ? requestShader(s, ShaderPass::Levels, permutation) : ShaderRequest(nullptr);
+        if (!casRequest || !fakeHdrRequest || !levelsRequest) {
+            utils::telemetry::increment(Event::ShaderPending);
+            return false;
+        }
+        ID3D11ComputeShader* casCS = *casRequest;
+        if (!casCS) {
+            utils::telemetry::increment(Event::ShaderFailed);
+            return false;
+        }
+        // The optional passes are skipped when disabled or when their permutation failed to build.
+        ID3D11ComputeShader* fakeHdrCS = *fakeHdrRequest;
+        ID3D11ComputeShader* levelsCS = *levelsRequest;
+        const bool isMultisampled = td.SampleDesc.Count > 1;
+
+        const UINT copyWidth = sub.imageRect.extent.width ? (UINT)sub.imageRect.extent.width : td.Width;
+        const UINT copyHeight = sub.imageRect.extent.height ? (UINT)sub.imageRect.extent.height : td.Height;
+        const XrRect2Di inRect{sub.imageRect.offset, {(int32_t)copyWidth, (int32_t)copyHeight}};
+        const XrRect2Di& outRect = outputRect;
+        const UINT width = (UINT)outRect.extent.width;
+        const UINT height = (UINT)outRect.extent.height;
+        const bool upscaling = width != copyWidth || height != copyHeight;
+        ID3D11ComputeShader* scalingCS = nullptr;
+        if (upscaling) {
+            if (!CasSupportScaling((float)width, (float)height, (float)copyWidth, (float)copyHeight)) {
+                utils::telemetry::increment(Event::ScalingUnsupported);
+                return false;
+            }
+            ShaderPermutation scalingPermutation = permutation;
+            scalingPermutation.scaling = true;
+            const ShaderRequest scalingRequest = requestShader(s, ShaderPass::Cas, scalingPermutation);
+            if (!scalingRequest || !*scalingRequest) {
+                utils::telemetry::increment(scalingRequest ? Event::ShaderFailed : Event::ShaderPending);
+                return false;
+            }
+            scalingCS = *scalingRequest;
+        }
+
+        // Use pooled temporary textures, held until the passes are recorded. When upscaling, the source resolution
+        // pair only holds the input, all other passes use the output resolution pair.
+        uint32_t slotId = 0;
+        TempTextures* const slotTextures =
+            acquireTempTextures(pool, d3d, td, makeTempKey(td.Width, td.Height, formatInfo->resourceFormat), slotId);
+        if (!slotTextures) {
+            return false;
+        }
+        auto releaseSlot = wil::scope_exit([&]() { pool.release(slotId); });
+        TempTextures& slot = *slotTextures;
+        TempTextures* work = &slot;
+        std::optional<uint32_t> workId;
+        auto releaseWork = wil::scope_exit([&]() {
+            if (workId) {
+                pool.release(*workId);
+            }
+        });
+        if (upscaling) {
+            uint32_t id = 0;
+            work = acquireTempTextures(
+                pool, d3d, td, makeTempKey(dstDesc.Width, dstDesc.Height, formatInfo->resourceFormat), id);
+            if (!work) {
+                return false;
+            }
+            workId = id;
+        }
+
+        // Map formats for SRV/UAV
+        const DXGI_FORMAT srvFormat = formatInfo->srvFormat;
+        const DXGI_FORMAT uavFormat = storePlan.uavFormat;
+
+        // SRV/UAV descs shared by all passes
+        D3D11_SHADER_RESOURCE_VIEW_DESC srvd{};
+        srvd.Format = srvFormat;
+        srvd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvd.Texture2D.MipLevels = 1;
+        srvd.Texture2D.MostDetailedMip = 0;
+
+        D3D11_UNORDERED_ACCESS_VIEW_DESC uavd{};
+        uavd.Format = uavFormat;
+        uavd.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+        uavd.Texture2D.MipSlice = 0;
+
+        // Constants
+        float userSharp = s->sharpness;
+        // Allow >1.0 by scaling the CAS internal strength non-linearly.
+        // For values >1.0, apply an extra multiplier to emulate "super sharp" beyond standard CAS.
+        float casStrength = userSharp;
+        if (userSharp > 1.0f) {
+            casStrength = 1.0f; // saturate CAS's own tuning to 1
+        }
+        const UINT tgx = (width + 15) / 16;
+        const UINT tgy = (height + 15) / 16;
+        int totalPasses = 1;
+        if (userSharp > 1.0f) {
+            int extra = (int)floorf(userSharp - 1.0f);
+            if (extra < 0) extra = 0; if (extra > 3) extra = 3;
+            totalPasses += extra;
+        }
+
+        // The optional passes are culled from the graph when their constants are not available.
+        ID3D11Buffer* hdrCB = nullptr;
+        if (fakeHdrCS) {
+            struct { float pwr, r1, r2, pad0; UINT offx, offy, extx, exty; } cb{};
+            cb.pwr = s->fakeHdrPower; cb.r1 = s->fakeHdrRadius1; cb.r2 = s->fakeHdrRadius2; cb.pad0 = 0.0f;
+            cb.offx = outRect.offset.x;
+            cb.offy = outRect.offset.y;
+            cb.extx = width;
+            cb.exty = height;
+            hdrCB = s->constants.update(
+                d3d, ctx, makeConstantsKey(swapchain, sub.imageArrayIndex, ConstantsSlot::FakeHdr), &cb, sizeof(cb));
+        }
+        ID3D11Buffer* lvCB = nullptr;
+        if (levelsCS) {
+            struct { float inB, inW, outB, outW; float gamma, pad1, pad2, pad3; UINT offx, offy, extx, exty; } lv{};
+            lv.inB = s->levelsInBlack; lv.inW = s->levelsInWhite; lv.outB = s->levelsOutBlack; lv.outW = s->levelsOutWhite; lv.gamma = s->levelsGamma;
+            lv.offx = outRect.offset.x; lv.offy = outRect.offset.y; lv.extx = width; lv.exty = height;
+            lvCB = s->constants.update(
+                d3d, ctx, makeConstantsKey(swapchain, sub.imageArrayIndex, ConstantsSlot::Levels), &lv, sizeof(lv));
+        }
+        utils::passgraph::PassGraph& graph = s->passGraph;
+        if (!buildPassGraph(graph, totalPasses, upscaling, hdrCB != nullptr, lvCB != nullptr, converting)) {
+            return false;
+        }
+
+        // The converting permutation of the last compute pass, and its output in the destination format.
+        ID3D11ComputeShader* conversionCS = nullptr;
+        TempTextures* conversion = nullptr;
+        std::optional<uint32_t> conversionId;
+        auto releaseConversion = wil::scope_exit([&]() {
+            if (conversionId) {
+                pool.release(*conversionId);
+            }
+        });
+        if (converting) {
+            const auto& steps = graph.getSteps();
+            const auto last = std::find_if(steps.cbegin(), steps.cend(), [](const utils::passgraph::Step& step) {
+                return step.output.sizeClass == ConversionSizeClass;
+            });
+            if (last == steps.cend()) {
+                return false;
+            }
+            const GraphPass lastPass = (GraphPass)last->tag;
+            ShaderPermutation lastPermutation = permutation;
+            lastPermutation.scaling = lastPass == GraphPass::CasScaling;
+            const ShaderRequest conversionRequest =
+                requestShader(s,
+                              lastPass == GraphPass::FakeHdr  ? ShaderPass::FakeHdr
+                              : lastPass == GraphPass::Levels ? ShaderPass::Levels
+                                                              : ShaderPass::Cas,
+                              getConversionPermutation(s, lastPermutation, *dstFormatInfo, *dstPlan));
+            if (!conversionRequest || !*conversionRequest) {
+                utils::telemetry::increment(conversionRequest ? Event::ShaderFailed : Event::ShaderPending);
+                return false;
+            }
+            conversionCS = *conversionRequest;
+
+            D3D11_TEXTURE2D_DESC conversionDesc = td;
+            conversionDesc.Format = destinationFormat;
+            uint32_t id = 0;
+            conversion = acquireTempTextures(pool,
+                                             d3d,
+                                             conversionDesc,
+                                             makeTempKey(upscaling ? dstDesc.Width : td.Width,
+                                                         upscaling ? dstDesc.Height : td.Height,
+                                                         dstFormatInfo->resourceFormat),
+                                             id);
+            if (!conversion) {
+                return false;
+            }
+            conversionId = id;
+        }
+
+        // Each size class has a pair of pooled textures, which is all a chain needs.
+        TempTextures* const pairs[] = {&slot, work, conversion};
+        const auto getTexture = [&](const utils::passgraph::Texture& texture) -> ID3D11Texture2D* {
+            if (texture.isImported()) {
+                return texture.index == 0 ? source : destination;
+            }
+            return texture.index == 0 ? pairs[texture.sizeClass]->input.Get() : pairs[texture.sizeClass]->output.Get();
+        };
+
+        collectGpuTimings(s);
+        const bool timing = s->qDisjoint && !s->timingPending;
+        uint32_t nextTimestamp = 0;
+
+        utils::recorder::StateRecorder& recorder = *s->recorder;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> curSRV;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> curUAV;
+        const char* stageName = nullptr;
+        for (const auto& step : graph.getSteps()) {
+            const GraphPass pass = (GraphPass)step.tag;
+            if (getGraphPassName(pass) != stageName) {
+                stageName = getGraphPassName(pass);
+                stage.emplace(stageName);
+            }
+            // Stages culled from the graph get two identical timestamps.
+            while (timing && pass != GraphPass::CopyIn && nextTimestamp <= getGpuStage(pass)) {
+                if (nextTimestamp == 0) {
+                    ctx->Begin(s->qDisjoint.Get());
                 }
-            };
-            DXGI_FORMAT resourceFormat = chooseTypeless(td.Format);
-            texDesc.Format = resourceFormat;
-            // Input: SRV+UAV (for ping-pong passes and Levels)
-            texDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
-            if (FAILED(d3d->CreateTexture2D(&texDesc, nullptr, slot.input.ReleaseAndGetAddressOf()))) {
-                ErrorLog("CAS: CreateTexture2D input failed\n");
-                return;
+                ctx->End(s->qTimestamps[nextTimestamp++].Get());
             }
-            // Output: UAV+SRV
-            texDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
-            if (FAILED(d3d->CreateTexture2D(&texDesc, nullptr, slot.output.ReleaseAndGetAddressOf()))) {
-                ErrorLog("CAS: CreateTexture2D output failed\n");
-                return;
+            // D3D11 needs no barriers, but a texture moving from the shaders to a copy must not stay bound. The
+            // recorder already clears the UAV/SRV hazards between passes.
+            const auto barriers = graph.getBarriers().cbegin() + step.firstBarrier;
+            if (std::any_of(barriers, barriers + step.barrierCount, [](const utils::passgraph::Barrier& barrier) {
+                    return (barrier.before == utils::passgraph::Access::ShaderRead ||
+                            barrier.before == utils::passgraph::Access::ShaderWrite) &&
+                           (barrier.after == utils::passgraph::Access::CopySource ||
+                            barrier.after == utils::passgraph::Access::CopyDest);
+                })) {
+                recorder.unbindResources();
             }
-            slot.width = td.Width; slot.height = td.Height; slot.format = td.Format;
+
+            ID3D11Texture2D* const input = getTexture(step.input);
+            ID3D11Texture2D* const output = getTexture(step.output);
+            if (pass == GraphPass::CopyIn) {
+                // Copy source slice/rect into input. Use mip 0 always.
+                // The input texture is at least the size of the source, so the rect keeps the same coordinates.
+                UINT srcSubresource = D3D11CalcSubresource(0, sub.imageArrayIndex, td.MipLevels);
+                ID3D11Texture2D* copySource = input;
+                if (isMultisampled) {
+                    copySource = getResolvedSlice(s, pool, input, td, sub.imageArrayIndex, *formatInfo);
+                    if (!copySource) {
+                        return false;
+                    }
+                    srcSubresource = 0;
+                }
+                D3D11_BOX inBox{};
+                inBox.left = sub.imageRect.offset.x;
+                inBox.top = sub.imageRect.offset.y;
+                inBox.front = 0;
+                inBox.right = inBox.left + copyWidth;
+                inBox.bottom = inBox.top + copyHeight;
+                inBox.back = 1;
+                ctx->CopySubresourceRegion(output, 0, inBox.left, inBox.top, 0, copySource, srcSubresource, &inBox);
+                continue;
+            }
+            if (pass == GraphPass::CopyOut) {
+                // Copy back (only the processed slice/rect) to the destination array slice
+                const UINT dstSubresource = D3D11CalcSubresource(0, sub.imageArrayIndex, dstDesc.MipLevels);
+                D3D11_BOX box{};
+                box.left = outRect.offset.x;
+                box.top = outRect.offset.y;
+                box.front = 0;
+                box.right = outRect.offset.x + width;
+                box.bottom = outRect.offset.y + height;
+                box.back = 1;
+                ctx->CopySubresourceRegion(output, dstSubresource, box.left, box.top, 0, input, 0, &box);
+                continue;
+            }
+
+            const bool converts = step.output.sizeClass == ConversionSizeClass;
+            if (pass == GraphPass::CasScaling) {
+                recorder.setShader(converts ? conversionCS : scalingCS);
+                if (!bindCasConstants(s, swapchain, sub.imageArrayIndex, true, casStrength, inRect, outRect)) {
+                    return false;
+                }
+            } else if (pass == GraphPass::Cas) {
+                // After upscaling, the remaining passes only sharpen the upscaled image.
+                recorder.setShader(converts ? conversionCS : casCS);
+                if (!bindCasConstants(
+                        s, swapchain, sub.imageArrayIndex, false, casStrength, upscaling ? outRect : inRect, outRect)) {
+                    return false;
+                }
+            } else {
+                recorder.setShader(converts ? conversionCS : pass == GraphPass::FakeHdr ? fakeHdrCS : levelsCS);
+                utils::recorder::Handle cbs[1] = {pass == GraphPass::FakeHdr ? hdrCB : lvCB};
+                recorder.setConstantBuffers(0, 1, cbs);
+            }
+            D3D11_UNORDERED_ACCESS_VIEW_DESC passUavd = uavd;
+            if (converts) {
+                passUavd.Format = dstPlan->uavFormat;
+            }
+            curSRV.Reset(); curUAV.Reset();
+            if (FAILED(d3d->CreateShaderResourceView(input, &srvd, curSRV.ReleaseAndGetAddressOf())) ||
+                FAILED(d3d->CreateUnorderedAccessView(output, &passUavd, curUAV.ReleaseAndGetAddressOf()))) {
+                utils::telemetry::increment(Event::ViewCreationFailed);
+                return false;
+            }
+            recorder.setShaderResource(0, curSRV.Get());
+            recorder.setUnorderedAccessView(0, curUAV.Get());
+            recorder.dispatch(tgx, tgy, 1);
+        }
+
+        if (timing) {
+            ctx->End(s->qDisjoint.Get());
+            s->timingPending = true;
+        }
+        utils::telemetry::increment(Event::ViewProcessed);
+        return true;
+    }
+
+    // Read back the timestamps of a D3D12 frame retired since the last call, and update the averages.
+    static void collectGpuTimings12(SessionState* s) {
+        uint64_t timestamps[(uint32_t)utils::stats::GpuStage::Count + 1]{};
+        uint64_t frequency = 0;
+        if (s->d3d12->getTimestamps(timestamps, (uint32_t)std::size(timestamps), frequency) && frequency) {
+            accumulateGpuTimings(s, timestamps, double(frequency));
+        }
+    }
+
+    // The D3D12 counterpart of dispatchCas(), recorded into the current frame of the backend. The result is written
+    // back in place: D3D12 sessions are neither upscaled nor multisampled.
+    static bool dispatchCas12(SessionState* s,
+                              XrSwapchain swapchain,
+                              ID3D12Resource* image,
+                              const XrSwapchainCreateInfo& info,
+                              const XrSwapchainSubImage& sub,
+                              bool timing,
+                              utils::texturepool::Pool<utils::d3d12passes::TempTextures>& pool) {
+        using utils::telemetry::Event;
+        utils::profiler::Scope scope("dispatchCas");
+        std::optional<utils::profiler::Scope> stage;
+        utils::d3d12passes::Backend& backend = *s->d3d12;
+
+        // Swapchain images are often typeless, the format requested by the application tells how to view them.
+        const D3D12_RESOURCE_DESC desc = image->GetDesc();
+        const utils::formats::FormatInfo* formatInfo = utils::formats::getFormatInfo((DXGI_FORMAT)info.format);
+        if (!formatInfo || desc.SampleDesc.Count > 1) {
+            utils::telemetry::increment(Event::UnsupportedFormat);
+            return false;
+        }
+        // The state a released image is in, as specified by XR_KHR_D3D12_enable.
+        D3D12_RESOURCE_STATES imageState;
+        if (info.usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT) {
+            imageState = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        } else if (info.usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) {
+            imageState = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+        } else {
+            utils::telemetry::increment(Event::UnsupportedFormat);
+            return false;
+        }
+        const auto plan = getStorePlan(s, *formatInfo);
+        if (!plan) {
+            utils::telemetry::increment(Event::NoStorePlan);
+            return false;
+        }
+        const ShaderPermutation permutation = getPermutation(s, *formatInfo, *plan);
+
+        using PipelineRequest = std::optional<ID3D12PipelineState*>;
+        const PipelineRequest casRequest = requestPipeline(s, ShaderPass::Cas, permutation);
+        const PipelineRequest fakeHdrRequest =
+            s->fakeHdrEnabled ? requestPipeline(s, ShaderPass::FakeHdr, permutation) : PipelineRequest(nullptr);
+        const PipelineRequest levelsRequest =
+            s->levelsEnabled ? requestPipeline(s, ShaderPass::Levels, permutation) : PipelineRequest(nullptr);
+        if (!casRequest || !fakeHdrRequest || !levelsRequest) {
+            utils::telemetry::increment(Event::ShaderPending);
+            return false;
+        }
+        ID3D12PipelineState* casPipeline = *casRequest;
+        if (!casPipeline) {
+            utils::telemetry::increment(Event::ShaderFailed);
+            return false;
+        }
+        ID3D12PipelineState* fakeHdrPipeline = *fakeHdrRequest;
+        ID3D12PipelineState* levelsPipeline = *levelsRequest;
+
+        const UINT width = sub.imageRect.extent.width ? (UINT)sub.imageRect.extent.width : (UINT)desc.Width;
+        const UINT height = sub.imageRect.extent.height ? (UINT)sub.imageRect.extent.height : desc.Height;
+        const XrRect2Di rect{sub.imageRect.offset, {(int32_t)width, (int32_t)height}};
+
+        // The frames in flight keep the textures alive should the pool evict them.
+        const auto key = makeTempKey((UINT)desc.Width, desc.Height, formatInfo->resourceFormat);
+        uint32_t slotId = 0;
+        bool created = false;
+        utils::d3d12passes::TempTextures* slotTextures = pool.acquire(key, getTempTexturesBytes(key), slotId, created);
+        if (!countPoolAcquire(slotTextures, created)) {
+            return false;
+        }
+        if (created && !backend.ensureTempTextures(
+                           *slotTextures, key.width, key.height, formatInfo->format, formatInfo->resourceFormat)) {
+            pool.discard(slotId);
+            return false;
         }
-        // Copy source slice/rect into input. Use mip 0 always.
-        const UINT srcSubresource = D3D11CalcSubresource(0, sub.imageArrayIndex, 1);
-        const UINT dstSubresourceInput = D3D11CalcSubresource(0, 0, 1);
-        D3D11_BOX inBox{};
-        inBox.left = sub.imageRect.offset.x;
-        inBox.top = sub.imageRect.offset.y;
-        inBox.front = 0;
-        const UINT copyWidth = sub.imageRect.extent.width ? (UINT)sub.imageRect.extent.width : td.Width;
-        const UINT copyHeight = sub.imageRect.extent.height ? (UINT)sub.imageRect.extent.height : td.Height;
-        inBox.right = inBox.left + copyWidth;
-        inBox.bottom = inBox.top + copyHeight;
-        inBox.back = 1;
-        ctx->CopySubresourceRegion(slot.input.Get(), dstSubresourceInput, inBox.left, inBox.top, 0, source, srcSubresource, &inBox);
-
-        // Map formats for SRV/UAV if needed
-        auto mapSrvFormat = [](DXGI_FORMAT fmt) {
-            switch (fmt) {
-            case DXGI_FORMAT_R8G8B8A8_TYPELESS: return DXGI_FORMAT_R8G8B8A8_UNORM;
-            case DXGI_FORMAT_B8G8R8A8_TYPELESS: return DXGI_FORMAT_B8G8R8A8_UNORM;
-            case DXGI_FORMAT_B8G8R8X8_TYPELESS: return DXGI_FORMAT_B8G8R8X8_UNORM;
-            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM; // force UNORM for SRV
-            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB: return DXGI_FORMAT_B8G8R8A8_UNORM;
-            case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB: return DXGI_FORMAT_B8G8R8X8_UNORM;
-            default: return fmt;
-            }
-        };
-        auto mapUavFormat = [](DXGI_FORMAT fmt) {
-            switch (fmt) {
-            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return DXGI_FORMAT_R8G8B8A8_UNORM;
-            case DXGI_FORMAT_R8G8B8A8_TYPELESS: return DXGI_FORMAT_R8G8B8A8_UNORM;
-            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB: return DXGI_FORMAT_B8G8R8A8_UNORM;
-            case DXGI_FORMAT_B8G8R8A8_TYPELESS: return DXGI_FORMAT_B8G8R8A8_UNORM;
-            case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB: return DXGI_FORMAT_B8G8R8X8_UNORM;
-            case DXGI_FORMAT_B8G8R8X8_TYPELESS: return DXGI_FORMAT_B8G8R8X8_UNORM;
-            default: return fmt;
-            }
-        };
-        const DXGI_FORMAT srvFormat = mapSrvFormat(td.Format);
-        const DXGI_FORMAT uavFormat = mapUavFormat(td.Format);
-
-        // SRV/UAV descs reused for ping-pong
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvd{};
-        srvd.Format = srvFormat;
-        srvd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvd.Texture2D.MipLevels = 1;
-        srvd.Texture2D.MostDetailedMip = 0;
+        auto releaseSlot = wil::scope_exit([&]() { pool.release(slotId); });
+        utils::d3d12passes::TempTextures& slot = *slotTextures;
+
+        // The image goes back to the state the runtime expects, whether or not the passes make it to the end.
+        utils::d3d12passes::TrackedResource target{image, imageState};
+        auto restoreImage = wil::scope_exit([&]() { backend.transition(target, imageState); });
+
+        const UINT subresource = sub.imageArrayIndex * desc.MipLevels;
+        D3D12_BOX box{};
+        box.left = rect.offset.x;
+        box.top = rect.offset.y;
+        box.right = box.left + width;
+        box.bottom = box.top + height;
+        box.back = 1;
 
-        D3D11_UNORDERED_ACCESS_VIEW_DESC uavd{};
-        uavd.Format = uavFormat;
-        uavd.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
-        uavd.Texture2D.MipSlice = 0;
+        // Same constants as the D3D11 path, set as root constants (see utils::d3d12passes).
+        const float userSharp = s->sharpness;
+        const float casStrength = std::min(userSharp, 1.0f);
+        uint32_t casConsts[8]{};
+        CasSetup(casConsts, casConsts + 4, casStrength, (float)width, (float)height, (float)width, (float)height);
+        struct { UINT flags, offx, offy, extx; UINT exty, inx, iny, pad3; } rectConsts{};
+        rectConsts.offx = rectConsts.inx = rect.offset.x;
+        rectConsts.offy = rectConsts.iny = rect.offset.y;
+        rectConsts.extx = width;
+        rectConsts.exty = height;
+        struct { float pwr, r1, r2, pad0; UINT offx, offy, extx, exty; } cb{};
+        cb.pwr = s->fakeHdrPower; cb.r1 = s->fakeHdrRadius1; cb.r2 = s->fakeHdrRadius2;
+        cb.offx = rect.offset.x; cb.offy = rect.offset.y; cb.extx = width; cb.exty = height;
+        struct { float inB, inW, outB, outW; float gamma, pad1, pad2, pad3; UINT offx, offy, extx, exty; } lv{};
+        lv.inB = s->levelsInBlack; lv.inW = s->levelsInWhite; lv.outB = s->levelsOutBlack; lv.outW = s->levelsOutWhite; lv.gamma = s->levelsGamma;
+        lv.offx = rect.offset.x; lv.offy = rect.offset.y; lv.extx = width; lv.exty = height;
 
-        // Constants
-        uint32_t const0[4]{}, const1[4]{};
-        float userSharp = s->sharpness;
-        // Allow >1.0 by scaling the CAS internal strength non-linearly.
-        // For values >1.0, apply an extra multiplier to emulate "super sharp" beyond standard CAS.
-        float casStrength = userSharp;
-        if (userSharp > 1.0f) {
-            casStrength = 1.0f; // saturate CAS's own tuning to 1
-        }
-        CasSetup(const0, const1, casStrength, (float)td.Width, (float)td.Height, (float)td.Width, (float)td.Height);
-        D3D11_MAPPED_SUBRESOURCE map{};
-        if (SUCCEEDED(ctx->Map(s->constCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &map))) {
-            memcpy(map.pData, const0, sizeof(const0));
-            memcpy(reinterpret_cast<uint8_t*>(map.pData) + sizeof(const0), const1, sizeof(const1));
-            ctx->Unmap(s->constCB.Get(), 0);
-        }
-
-        // Timing begin
-        if (s->qDisjoint && s->qBegin && s->qEnd) {
-            ctx->Begin(s->qDisjoint.Get());
-            ctx->End(s->qBegin.Get());
-        }
-
-        // Dispatch passes (ping-pong for >1.0). Ensure UAV/SRV hazards are cleared per pass.
-        ctx->CSSetShader(s->cs.Get(), nullptr, 0);
-        ID3D11Buffer* cb = s->constCB.Get();
-        ctx->CSSetConstantBuffers(0, 1, &cb);
-        // Debug overlay disabled in production
-        uint32_t dbgFlags = 0u;
-        // Populate debug/rect CB: flags + sub-rect offset/extent
-        struct DebugCB { UINT flags, offx, offy, extx; UINT exty, pad1, pad2, pad3; } cbData{};
-        cbData.flags = dbgFlags;
-        cbData.offx = sub.imageRect.offset.x;
-        cbData.offy = sub.imageRect.offset.y;
-        cbData.extx = sub.imageRect.extent.width ? (UINT)sub.imageRect.extent.width : td.Width;
-        cbData.exty = sub.imageRect.extent.height ? (UINT)sub.imageRect.extent.height : td.Height;
-        D3D11_MAPPED_SUBRESOURCE mapDbg{};
-        if (SUCCEEDED(ctx->Map(s->debugCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapDbg))) {
-            memcpy(mapDbg.pData, &cbData, sizeof(cbData));
-            ctx->Unmap(s->debugCB.Get(), 0);
-        }
-        ID3D11Buffer* cbDebug = s->debugCB.Get();
-        ctx->CSSetConstantBuffers(1, 1, &cbDebug);
-        const UINT width = copyWidth;
-        const UINT height = copyHeight;
         const UINT tgx = (width + 15) / 16;
         const UINT tgy = (height + 15) / 16;
-        Log(fmt::format("CAS: dispatch {}x{} (groups {}x{}) format={} slice={}\n", width, height, tgx, tgy, (int)td.Format, (int)sub.imageArrayIndex));
         int totalPasses = 1;
         if (userSharp > 1.0f) {
-            int extra = (int)floorf(userSharp - 1.0f);
-            if (extra < 0) extra = 0; if (extra > 3) extra = 3;
-            totalPasses += extra;
+            totalPasses += std::clamp((int)floorf(userSharp - 1.0f), 0, 3);
         }
-        Microsoft::WRL::ComPtr<ID3D11Texture2D> readTex = slot.input;
-        Microsoft::WRL::ComPtr<ID3D11Texture2D> writeTex = slot.output;
-        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> curSRV;
-        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> curUAV;
-        UINT initCounts[1] = {0};
-        for (int pass = 0; pass < totalPasses; ++pass) {
-            // Bind SRV from readTex
-            curSRV.Reset(); curUAV.Reset();
-            if (FAILED(d3d->CreateShaderResourceView(readTex.Get(), &srvd, curSRV.ReleaseAndGetAddressOf()))) {
-                ErrorLog("CAS: Create SRV (pass) failed\n");
-                return;
+        utils::passgraph::PassGraph& graph = s->passGraph;
+        if (!buildPassGraph(
+                graph, totalPasses, false, fakeHdrPipeline != nullptr, levelsPipeline != nullptr, false)) {
+            return false;
+        }
+        // The image is both the source and the destination.
+        const auto getTexture = [&](const utils::passgraph::Texture& texture) -> utils::d3d12passes::TrackedResource& {
+            if (texture.isImported()) {
+                return target;
             }
-            ID3D11ShaderResourceView* srvsX[1] = {curSRV.Get()};
-            ctx->CSSetShaderResources(0, 1, srvsX);
-            // Bind UAV to writeTex
-            if (FAILED(d3d->CreateUnorderedAccessView(writeTex.Get(), &uavd, curUAV.ReleaseAndGetAddressOf()))) {
-                ErrorLog("CAS: Create UAV (pass) failed\n");
-                return;
+            return texture.index == 0 ? slot.input : slot.output;
+        };
+        const auto getState = [](utils::passgraph::Access access) {
+            switch (access) {
+            case utils::passgraph::Access::CopySource:
+                return D3D12_RESOURCE_STATE_COPY_SOURCE;
+            case utils::passgraph::Access::CopyDest:
+                return D3D12_RESOURCE_STATE_COPY_DEST;
+            case utils::passgraph::Access::ShaderRead:
+                return D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+            default:
+                return D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
             }
-            ID3D11UnorderedAccessView* uavsX[1] = {curUAV.Get()};
-            ctx->CSSetUnorderedAccessViews(0, 1, uavsX, initCounts);
-            // Dispatch
-            ctx->Dispatch(tgx, tgy, 1);
-            // Unbind to avoid hazards next pass
-            ID3D11UnorderedAccessView* nullU[1] = {nullptr};
-            ctx->CSSetUnorderedAccessViews(0, 1, nullU, initCounts);
-            ID3D11ShaderResourceView* nullS[1] = {nullptr};
-            ctx->CSSetShaderResources(0, 1, nullS);
-            // Ping-pong
-            std::swap(readTex, writeTex);
-        }
-
-        // Timing end & readback (best effort)
-        if (s->qDisjoint && s->qBegin && s->qEnd) {
-            ctx->End(s->qEnd.Get());
-            ctx->End(s->qDisjoint.Get());
-            D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
-            if (S_OK == ctx->GetData(s->qDisjoint.Get(), &disjoint, sizeof(disjoint), 0) && !disjoint.Disjoint) {
-                UINT64 t0=0, t1=0;
-                if (S_OK == ctx->GetData(s->qBegin.Get(), &t0, sizeof(t0), 0) && S_OK == ctx->GetData(s->qEnd.Get(), &t1, sizeof(t1), 0)) {
-                    double ms = double(t1 - t0) / double(disjoint.Frequency) * 1000.0;
-                    s->timingAccumMs += ms;
-                    if (++s->timingFrameCounter >= 120) {
-                        Log(fmt::format("CAS average GPU cost: {:.3f} ms\n", s->timingAccumMs / s->timingFrameCounter));
-                        s->timingAccumMs = 0.0; s->timingFrameCounter = 0;
-                    }
-                }
+        };
+
+        const DXGI_FORMAT srvFormat = formatInfo->srvFormat;
+        const DXGI_FORMAT uavFormat = plan->uavFormat;
+        uint32_t nextTimestamp = 0;
+        const char* stageName = nullptr;
+        for (const auto& step : graph.getSteps()) {
+            const GraphPass pass = (GraphPass)step.tag;
+            if (getGraphPassName(pass) != stageName) {
+                stageName = getGraphPassName(pass);
+                stage.emplace(stageName);
+            }
+            while (timing && pass != GraphPass::CopyIn && nextTimestamp <= getGpuStage(pass)) {
+                backend.writeTimestamp(nextTimestamp++);
+            }
+            // The backend batches the barriers of the step until its copy or dispatch.
+            const auto& barriers = graph.getBarriers();
+            for (uint32_t i = step.firstBarrier; i < step.firstBarrier + step.barrierCount; i++) {
+                backend.transition(getTexture(barriers[i].texture), getState(barriers[i].after));
             }
-        }
 
-        // Ensure unbound
-        UINT dummyCounts[1] = {0};
-        ID3D11UnorderedAccessView* nullUAV[1] = {nullptr};
-        ctx->CSSetUnorderedAccessViews(0, 1, nullUAV, dummyCounts);
-        ID3D11ShaderResourceView* nullSRV[1] = {nullptr};
-        ctx->CSSetShaderResources(0, 1, nullSRV);
-
-        // Optional post-CAS passes
-        // Determine final output of CAS passes: last swap put latest result into 'readTex'
-        Microsoft::WRL::ComPtr<ID3D11Texture2D> casFinalTex = readTex;
-
-        // Optional FakeHDR pass (before Levels)
-        if (s->fakeHdrEnabled && s->fakeHdrCS && s->fakeHdrCB) {
-            // Update constants
-            D3D11_MAPPED_SUBRESOURCE mapH{};
-            if (SUCCEEDED(ctx->Map(s->fakeHdrCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapH))) {
-                struct { float pwr, r1, r2, pad0; UINT offx, offy, extx, exty; } cb{};
-                cb.pwr = s->fakeHdrPower; cb.r1 = s->fakeHdrRadius1; cb.r2 = s->fakeHdrRadius2; cb.pad0 = 0.0f;
-                cb.offx = sub.imageRect.offset.x;
-                cb.offy = sub.imageRect.offset.y;
-                cb.extx = copyWidth;
-                cb.exty = copyHeight;
-                memcpy(mapH.pData, &cb, sizeof(cb));
-                ctx->Unmap(s->fakeHdrCB.Get(), 0);
-            }
-            // Read from casFinalTex, write to the other temp
-            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> hdrSRV;
-            D3D11_SHADER_RESOURCE_VIEW_DESC srvdH = srvd;
-            d3d->CreateShaderResourceView(casFinalTex.Get(), &srvdH, hdrSRV.ReleaseAndGetAddressOf());
-            Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> hdrUAV;
-            D3D11_UNORDERED_ACCESS_VIEW_DESC uavdH = uavd;
-            ID3D11Texture2D* hdrDst = (casFinalTex.Get() == slot.input.Get()) ? slot.output.Get() : slot.input.Get();
-            d3d->CreateUnorderedAccessView(hdrDst, &uavdH, hdrUAV.ReleaseAndGetAddressOf());
-
-            ctx->CSSetShader(s->fakeHdrCS.Get(), nullptr, 0);
-            ID3D11Buffer* hdrCB = s->fakeHdrCB.Get();
-            ctx->CSSetConstantBuffers(0, 1, &hdrCB);
-            ID3D11ShaderResourceView* srvsH[1] = {hdrSRV.Get()};
-            ctx->CSSetShaderResources(0, 1, srvsH);
-            ID3D11UnorderedAccessView* uavsH[1] = {hdrUAV.Get()};
-            ctx->CSSetUnorderedAccessViews(0, 1, uavsH, dummyCounts);
-            ctx->Dispatch(tgx, tgy, 1);
-            // Unbind
-            ID3D11UnorderedAccessView* nullUAVH[1] = {nullptr};
-            ctx->CSSetUnorderedAccessViews(0, 1, nullUAVH, dummyCounts);
-            ID3D11ShaderResourceView* nullSRVH[1] = {nullptr};
-            ctx->CSSetShaderResources(0, 1, nullSRVH);
-            // Update final tex
-            casFinalTex = hdrDst;
-        }
-
-        if (s->levelsEnabled && s->levelsCS && s->levelsCB) {
-            D3D11_MAPPED_SUBRESOURCE mapL{};
-            if (SUCCEEDED(ctx->Map(s->levelsCB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapL))) {
-                struct { float inB, inW, outB, outW; float gamma, pad1, pad2, pad3; } lv{};
-                lv.inB = s->levelsInBlack; lv.inW = s->levelsInWhite; lv.outB = s->levelsOutBlack; lv.outW = s->levelsOutWhite; lv.gamma = s->levelsGamma;
-                memcpy(mapL.pData, &lv, sizeof(lv));
-                ctx->Unmap(s->levelsCB.Get(), 0);
-            }
-            // Read from casFinalTex, write to the other temp
-            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> levelsSRV;
-            D3D11_SHADER_RESOURCE_VIEW_DESC srvd2 = srvd; // same format/dimensions as earlier
-            d3d->CreateShaderResourceView(casFinalTex.Get(), &srvd2, levelsSRV.ReleaseAndGetAddressOf());
-            Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> levelsUAV;
-            D3D11_UNORDERED_ACCESS_VIEW_DESC uavd2 = uavd;
-            // choose destination: if casFinalTex==slot.input then write into slot.output else into slot.input
-            ID3D11Texture2D* levelsDst = (casFinalTex.Get() == slot.input.Get()) ? slot.output.Get() : slot.input.Get();
-            d3d->CreateUnorderedAccessView(levelsDst, &uavd2, levelsUAV.ReleaseAndGetAddressOf());
-
-            ctx->CSSetShader(s->levelsCS.Get(), nullptr, 0);
-            ID3D11Buffer* lvCB = s->levelsCB.Get();
-            ctx->CSSetConstantBuffers(0, 1, &lvCB);
-            ID3D11ShaderResourceView* srvsL[1] = {levelsSRV.Get()};
-            ctx->CSSetShaderResources(0, 1, srvsL);
-            ID3D11UnorderedAccessView* uavsL[1] = {levelsUAV.Get()};
-            ctx->CSSetUnorderedAccessViews(0, 1, uavsL, dummyCounts);
-            ctx->Dispatch(tgx, tgy, 1);
-            ID3D11UnorderedAccessView* nullUAVL[1] = {nullptr};
-            ctx->CSSetUnorderedAccessViews(0, 1, nullUAVL, dummyCounts);
-            ID3D11ShaderResourceView* nullSRVL[1] = {nullptr};
-            ctx->CSSetShaderResources(0, 1, nullSRVL);
-        // After levels, latest output is now in 'levelsDst'
-        // Set casFinalTex to the ComPtr that owns that resource
-        if (levelsDst == slot.input.Get()) {
-            casFinalTex = slot.input;
-        } else {
-            casFinalTex = slot.output;
-        }
+            utils::d3d12passes::TrackedResource& input = getTexture(step.input);
+            utils::d3d12passes::TrackedResource& output = getTexture(step.output);
+            if (pass == GraphPass::CopyIn) {
+                backend.copyRegion(output, 0, box.left, box.top, input, subresource, box);
+                continue;
+            }
+            if (pass == GraphPass::CopyOut) {
+                backend.copyRegion(output, subresource, box.left, box.top, input, 0, box);
+                continue;
+            }
+
+            bool set = false;
+            if (pass == GraphPass::Cas) {
+                set = backend.setPass(casPipeline,
+                                      casConsts,
+                                      sizeof(casConsts),
+                                      &rectConsts,
+                                      sizeof(rectConsts),
+                                      input,
+                                      srvFormat,
+                                      output,
+                                      uavFormat);
+            } else if (pass == GraphPass::FakeHdr) {
+                set = backend.setPass(fakeHdrPipeline, &cb, sizeof(cb), nullptr, 0, input, srvFormat, output, uavFormat);
+            } else if (pass == GraphPass::Levels) {
+                set = backend.setPass(levelsPipeline, &lv, sizeof(lv), nullptr, 0, input, srvFormat, output, uavFormat);
+            }
+            if (!set) {
+                utils::telemetry::increment(Event::ViewCreationFailed);
+                return false;
+            }
+            backend.dispatch(tgx, tgy, 1);
         }
 
-        // Copy back (only the processed slice/rect)
-        const UINT dstSubresource = D3D11CalcSubresource(0, sub.imageArrayIndex, 1);
-        const UINT srcSubresourceOutput = D3D11CalcSubresource(0, 0, 1);
-        D3D11_BOX box{};
-        box.left = sub.imageRect.offset.x;
-        box.top = sub.imageRect.offset.y;
-        box.front = 0;
-        box.right = sub.imageRect.offset.x + width;
-        box.bottom = sub.imageRect.offset.y + height;
-        box.back = 1;
-        // Copy back from final CAS/Levels output to the original array slice
-        ctx->CopySubresourceRegion(source, dstSubresource, box.left, box.top, 0, casFinalTex.Get(), srcSubresourceOutput, &box);
-        Log("CAS: completed\n");
+        utils::telemetry::increment(Event::ViewProcessed);
+        return true;
     }
 
     // This class implements our API layer.
@@ -704,6 +1776,9 @@ namespace openxr_api_layer {
 
             XrResult result = m_bypassApiLayer ? m_xrGetInstanceProcAddr(instance, name, function)
                                                : OpenXrApi::xrGetInstanceProcAddr(instance, name, function);
+            if (XR_SUCCEEDED(result) && !m_bypassApiLayer && m_compFactory) {
+                m_compFactory->xrGetInstanceProcAddr_post(instance, name, function);
+            }
 
             TraceLoggingWrite(g_traceProvider, "xrGetInstanceProcAddr", TLPArg(*function, "Function"));
 
@@ -770,6 +1845,21 @@ namespace openxr_api_layer {
                         out << "# OpenXR CAS Layer configuration\n";
                         out << "# Sharpening strength (>=0). Values >1.0 apply multiple CAS passes.\n";
                         out << "sharpness=0.6\n";
+                        out << "\n# sRGB swapchains: use the exact transfer function instead of a fast approximation (0/1)\n";
+                        out << "srgb_exact=0\n";
+                        out << "\n# Format of the layer's output swapchains: app or runtime\n";
+                        out << "# (the runtime's preferred format, converted by the last pass)\n";
+                        out << "output_format=app\n";
+                        out << "\n# Preserve the application's compute state around the layer's passes:\n";
+                        out << "# targeted (only the slots the layer uses), context_state (swap whole context states) or none\n";
+                        out << "state_restore=targeted\n";
+                        out << "\n# Upscale mode (0/1): the application renders at upscale_factor (0.5-1.0) of the recommended\n";
+                        out << "# resolution, CAS upscales to full resolution\n";
+                        out << "upscale_enable=0\n";
+                        out << "upscale_factor=0.77\n";
+                        out << "# Adjust the render scale to the frame time, between upscale_min_factor and 1.0 (0/1)\n";
+                        out << "upscale_dynamic=0\n";
+                        out << "upscale_min_factor=0.5\n";
                         out << "\n# Debug overlay (0/1) and number of frames for border/overlay\n";
                         out << "debug_overlay=0\n";
                         out << "debug_frames=60\n";
@@ -785,6 +1875,14 @@ namespace openxr_api_layer {
                         out << "fakehdr_power=1.30\n";
                         out << "fakehdr_radius1=0.793\n";
                         out << "fakehdr_radius2=0.87\n";
+                        out << "\n# CPU profiling (0/1): write a Chrome trace (chrome://tracing, ui.perfetto.dev) to trace.json\n";
+                        out << "# when the session ends\n";
+                        out << "profile_trace=0\n";
+                        out << "\n# Publish frame statistics in shared memory for monitoring tools (0/1)\n";
+                        out << "stats_enable=1\n";
+                        out << "\n# Temporary texture pool: trimmed to the budget when idle, never above the cap (MB)\n";
+                        out << "pool_budget_mb=256\n";
+                        out << "pool_cap_mb=1024\n";
                         out.close();
                         Log(fmt::format("Created default config at {}\n", cfgPath.string()));
                     }
@@ -809,6 +1907,66 @@ namespace openxr_api_layer {
             } catch (...) {
             }
 
+            // The upscale settings are read here, the application queries the view configuration before it creates
+            // its session.
+            if (auto s = tryReadConfigValue("upscale_enable")) {
+                std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                m_upscaleEnabled = (v=="1"||v=="true"||v=="yes");
+            }
+            if (auto s = tryReadConfigValue("upscale_factor")) try { m_upscaleFactor = std::stof(*s); } catch (...) {}
+            // CAS cannot upscale more than 4x in area.
+            m_upscaleFactor = std::clamp(m_upscaleFactor, 0.5f, 1.0f);
+            // Upscaling needs an output swapchain from the composition framework, which D3D12 sessions do not use.
+            // The graphics API is only known at session creation, but the view configuration is queried before: go by
+            // the extensions the application enabled.
+            bool hasD3D11 = false, hasD3D12 = false;
+            for (uint32_t i = 0; i < createInfo->enabledExtensionCount; i++) {
+                const std::string_view extensionName(createInfo->enabledExtensionNames[i]);
+                hasD3D11 = hasD3D11 || extensionName == XR_KHR_D3D11_ENABLE_EXTENSION_NAME;
+                hasD3D12 = hasD3D12 || extensionName == XR_KHR_D3D12_ENABLE_EXTENSION_NAME;
+            }
+            if (m_upscaleEnabled && hasD3D12 && !hasD3D11) {
+                Log("CAS upscale: not supported with D3D12, disabled\n");
+                m_upscaleEnabled = false;
+            }
+            if (m_upscaleEnabled) {
+                Log(fmt::format("CAS upscale: render scale {:.3f}\n", m_upscaleFactor));
+            }
+            bool upscaleDynamic = false;
+            if (auto s = tryReadConfigValue("upscale_dynamic")) {
+                std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                upscaleDynamic = (v=="1"||v=="true"||v=="yes");
+            }
+            bool statsEnabled = true;
+            if (auto s = tryReadConfigValue("stats_enable")) {
+                std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                statsEnabled = (v=="1"||v=="true"||v=="yes");
+            }
+            if (statsEnabled && m_statsWriter.open()) {
+                Log(fmt::format("Statistics published as {}\n", utils::stats::getSharedMemoryName(GetCurrentProcessId())));
+            }
+
+            if (auto s = tryReadConfigValue("profile_trace")) {
+                std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                utils::profiler::setEnabled(v=="1"||v=="true"||v=="yes");
+            }
+
+            uint32_t poolBudgetMb = 256, poolCapMb = 1024;
+            if (auto s = tryReadConfigValue("pool_budget_mb")) try { poolBudgetMb = (uint32_t)std::stoul(*s); } catch (...) {}
+            if (auto s = tryReadConfigValue("pool_cap_mb")) try { poolCapMb = (uint32_t)std::stoul(*s); } catch (...) {}
+            m_texturePool.setLimits(uint64_t(poolBudgetMb) << 20, uint64_t(poolCapMb) << 20);
+            m_texturePool12.setLimits(uint64_t(poolBudgetMb) << 20, uint64_t(poolCapMb) << 20);
+
+            if (m_upscaleEnabled && upscaleDynamic) {
+                utils::dynres::ControllerSettings settings;
+                if (auto s = tryReadConfigValue("upscale_min_factor")) try { settings.minScale = std::stof(*s); } catch (...) {}
+                settings.minScale = std::clamp(settings.minScale, 0.5f, 1.0f);
+                m_dynamicResolution.emplace(settings);
+                m_dynamicResolution->reset(m_upscaleFactor);
+                m_upscaleFactor = m_dynamicResolution->getScale();
+                Log(fmt::format("CAS upscale: dynamic render scale {:.3f}-1.000\n", settings.minScale));
+            }
+
             return XR_SUCCESS;
         }
 
@@ -841,6 +1999,65 @@ namespace openxr_api_layer {
             return result;
         }
 
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrEnumerateViewConfigurationViews
+        XrResult xrEnumerateViewConfigurationViews(XrInstance instance,
+                                                   XrSystemId systemId,
+                                                   XrViewConfigurationType viewConfigurationType,
+                                                   uint32_t viewCapacityInput,
+                                                   uint32_t* viewCountOutput,
+                                                   XrViewConfigurationView* views) override {
+            const XrResult result = OpenXrApi::xrEnumerateViewConfigurationViews(
+                instance, systemId, viewConfigurationType, viewCapacityInput, viewCountOutput, views);
+            if (XR_SUCCEEDED(result) && views && isSystemHandled(systemId)) {
+                m_recommendedViewSizes.resize(*viewCountOutput);
+                for (uint32_t i = 0; i < *viewCountOutput; i++) {
+                    RecommendedViewSize& size = m_recommendedViewSizes[i];
+                    size.nativeWidth = size.width = views[i].recommendedImageRectWidth;
+                    size.nativeHeight = size.height = views[i].recommendedImageRectHeight;
+                    if (!isUpscaling()) {
+                        continue;
+                    }
+
+                    // Advertise the reduced resolution. The maximum is left untouched, an application that ignores the
+                    // recommendation is upscaled all the same.
+                    size.width = std::max((uint32_t)std::lround(size.nativeWidth * m_upscaleFactor), 1u);
+                    size.height = std::max((uint32_t)std::lround(size.nativeHeight * m_upscaleFactor), 1u);
+                    views[i].recommendedImageRectWidth = size.width;
+                    views[i].recommendedImageRectHeight = size.height;
+                    Log(fmt::format("CAS upscale: view {} recommended resolution {}x{}\n", i, size.width, size.height));
+                }
+            }
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrWaitFrame
+        XrResult xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState) override {
+            const XrResult result = OpenXrApi::xrWaitFrame(session, frameWaitInfo, frameState);
+            if (XR_SUCCEEDED(result) && m_dynamicResolution) {
+                // A gap of more than one period between two predicted display times means that frames were dropped.
+                const XrDuration period = frameState->predictedDisplayPeriod;
+                m_displayPeriodMs = period / 1e6;
+                m_droppedFrameTimeMs = 0.0;
+                if (m_lastPredictedDisplayTime && period > 0) {
+                    const XrDuration delta = frameState->predictedDisplayTime - m_lastPredictedDisplayTime;
+                    if (delta > period + period / 2) {
+                        m_droppedFrameTimeMs = delta / 1e6;
+                    }
+                }
+                m_lastPredictedDisplayTime = frameState->predictedDisplayTime;
+            }
+            return result;
+        }
+
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrBeginFrame
+        XrResult xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo) override {
+            const XrResult result = OpenXrApi::xrBeginFrame(session, frameBeginInfo);
+            if (XR_SUCCEEDED(result) && m_dynamicResolution) {
+                m_frameBeginTime = std::chrono::steady_clock::now();
+            }
+            return result;
+        }
+
         // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrCreateSession
         XrResult xrCreateSession(XrInstance instance,
                                  const XrSessionCreateInfo* createInfo,
@@ -877,16 +2094,35 @@ namespace openxr_api_layer {
                             ID3D11DeviceContext* tmpCtx = nullptr;
                             state->appD3DDevice->GetImmediateContext(&tmpCtx);
                             state->appD3DContext.Attach(tmpCtx);
+                            state->recorder = std::make_unique<utils::recorder::StateRecorder>(
+                                utils::recorder::createD3D11ComputeBindings(tmpCtx));
                         }
                         break;
                     }
+                    if (cur->type == XR_TYPE_GRAPHICS_BINDING_D3D12_KHR) {
+                        const XrGraphicsBindingD3D12KHR* d3d12 = reinterpret_cast<const XrGraphicsBindingD3D12KHR*>(cur);
+                        state->appD3D12Device = d3d12->device;
+                        state->appD3D12Queue = d3d12->queue;
+                        break;
+                    }
                     cur = cur->next;
                 }
-                if (!state->appD3DDevice) {
-                    Log("CAS layer: no D3D11 graphics binding found; layer will be inactive for this session\n");
+                if (state->appD3D12Device && state->appD3D12Queue) {
+                    try {
+                        state->d3d12 = std::make_unique<utils::d3d12passes::Backend>(state->appD3D12Device.Get(),
+                                                                                     state->appD3D12Queue.Get());
+                        Log("CAS layer: using the D3D12 backend on the application's queue\n");
+                    } catch (std::exception& exc) {
+                        ErrorLog(fmt::format("CAS layer: failed to create the D3D12 backend: {}\n", exc.what()));
+                    }
+                }
+                if (!state->appD3DDevice && !state->d3d12) {
+                    Log("CAS layer: no D3D11 or D3D12 graphics binding found; layer will be inactive for this session\n");
                 }
 
-                state->sharpness = resolveSharpnessFromConfigOrEnv();
+                readConfigTunables(state.get());
+                state->cfgLastWriteTimes = getConfigWriteTimes();
+                state->stats.sessionId = m_nextSessionId++;
                 // Read debug controls from env or config
                 // Frames
                 {
@@ -911,30 +2147,72 @@ namespace openxr_api_layer {
                         state->debugOverlay = (val == "1" || val == "true" || val == "yes");
                     }
                 }
-                // Levels from config
-                {
-                    if (auto s = tryReadConfigValue("levels_enable")) {
-                        std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
-                        state->levelsEnabled = (v=="1"||v=="true"||v=="yes");
-                    }
-                    if (auto s = tryReadConfigValue("levels_in_black")) try { state->levelsInBlack = std::stof(*s); } catch (...) {}
-                    if (auto s = tryReadConfigValue("levels_in_white")) try { state->levelsInWhite = std::stof(*s); } catch (...) {}
-                    if (auto s = tryReadConfigValue("levels_out_black")) try { state->levelsOutBlack = std::stof(*s); } catch (...) {}
-                    if (auto s = tryReadConfigValue("levels_out_white")) try { state->levelsOutWhite = std::stof(*s); } catch (...) {}
-                    if (auto s = tryReadConfigValue("levels_gamma")) try { state->levelsGamma = std::stof(*s); } catch (...) {}
+                // sRGB decoding from config
+                if (auto s = tryReadConfigValue("srgb_exact")) {
+                    std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                    state->srgbExact = (v=="1"||v=="true"||v=="yes");
                 }
-                // FakeHDR from config
-                {
-                    if (auto s = tryReadConfigValue("fakehdr_enable")) {
-                        std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
-                        state->fakeHdrEnabled = (v=="1"||v=="true"||v=="yes");
-                    }
-                    if (auto s = tryReadConfigValue("fakehdr_power")) try { state->fakeHdrPower = std::stof(*s); } catch (...) {}
-                    if (auto s = tryReadConfigValue("fakehdr_radius1")) try { state->fakeHdrRadius1 = std::stof(*s); } catch (...) {}
-                    if (auto s = tryReadConfigValue("fakehdr_radius2")) try { state->fakeHdrRadius2 = std::stof(*s); } catch (...) {}
+                if (auto s = tryReadConfigValue("output_format")) {
+                    std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                    state->runtimeOutputFormat = (v == "runtime");
+                }
+                // Application state preservation from config
+                if (auto s = tryReadConfigValue("state_restore")) {
+                    std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                    if (v == "none") state->stateRestore = SessionState::StateRestore::None;
+                    else if (v == "context_state") state->stateRestore = SessionState::StateRestore::ContextState;
+                    else state->stateRestore = SessionState::StateRestore::Targeted;
+                }
+                // Levels and FakeHDR from config (their parameters are read with the other tunables)
+                if (auto s = tryReadConfigValue("levels_enable")) {
+                    std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                    state->levelsEnabled = (v=="1"||v=="true"||v=="yes");
+                }
+                if (auto s = tryReadConfigValue("fakehdr_enable")) {
+                    std::string v=*s; std::transform(v.begin(), v.end(), v.begin(), ::tolower);
+                    state->fakeHdrEnabled = (v=="1"||v=="true"||v=="yes");
                 }
                 Log(fmt::format("CAS sharpness set to {:.3f}\n", state->sharpness));
                 Log(fmt::format("CAS debug: overlay={} frames={}\n", state->debugOverlay ? 1 : 0, state->debugFramesMax));
+
+                // A private context state for the layer's passes, swapped with the application's at every frame.
+                if (state->appD3DDevice && state->stateRestore == SessionState::StateRestore::ContextState) {
+                    Microsoft::WRL::ComPtr<ID3D11Device1> device1;
+                    const D3D_FEATURE_LEVEL featureLevel = state->appD3DDevice->GetFeatureLevel();
+                    const UINT flags = (state->appD3DDevice->GetCreationFlags() & D3D11_CREATE_DEVICE_SINGLETHREADED)
+                                           ? D3D11_1_CREATE_DEVICE_CONTEXT_STATE_SINGLETHREADED
+                                           : 0;
+                    if (FAILED(state->appD3DDevice->QueryInterface(device1.ReleaseAndGetAddressOf())) ||
+                        FAILED(device1->CreateDeviceContextState(flags,
+                                                                 &featureLevel,
+                                                                 1,
+                                                                 D3D11_SDK_VERSION,
+                                                                 __uuidof(ID3D11Device),
+                                                                 nullptr,
+                                                                 state->layerContextState.ReleaseAndGetAddressOf()))) {
+                        ErrorLog("Failed to create a device context state; using targeted state restore\n");
+                        state->stateRestore = SessionState::StateRestore::Targeted;
+                    }
+                }
+
+                // Build the shaders and constant buffers off the frame loop. A single-threaded device cannot be used
+                // from another thread, then they are built right away.
+                if (state->appD3DDevice || state->d3d12) {
+                    SessionState* s = state.get();
+                    auto initialize = [s]() {
+                        const bool ready = ensureCasObjects(s);
+                        s->ready.store(ready, std::memory_order_release);
+                        Log(fmt::format("CAS objects {}\n", ready ? "ready" : "unavailable"));
+                        flushShaderCache();
+                    };
+                    if (state->appD3DDevice &&
+                        (state->appD3DDevice->GetCreationFlags() & D3D11_CREATE_DEVICE_SINGLETHREADED)) {
+                        initialize();
+                    } else {
+                        state->worker = std::make_unique<utils::worker::Worker>("CAS warm-up");
+                        state->worker->post(initialize);
+                    }
+                }
                 m_sessions[*session] = std::move(state);
 
                 TraceLoggingWrite(g_traceProvider, "xrCreateSession", TLXArg(*session, "Session"));
@@ -943,14 +2221,50 @@ namespace openxr_api_layer {
             return result;
         }
 
+        // https://www.khronos.org/registry/OpenXR/specs/1.0/html/xrspec.html#xrDestroySession
+        XrResult xrDestroySession(XrSession session) override {
+            // The swapchains of the session are destroyed along with it. Their output swapchains belong to the
+            // composition framework of the session, so they must go first.
+            std::vector<XrSwapchain> swapchains;
+            for (const auto& [swapchain, owner] : m_swapchainSessions) {
+                if (owner == session) {
+                    swapchains.push_back(swapchain);
+                }
+            }
+            for (XrSwapchain swapchain : swapchains) {
+                forgetSwapchain(swapchain);
+            }
+
+            // Stops the worker thread of the session. The permutations built without a worker are written last.
+            m_sessions.erase(session);
+            flushShaderCache();
+            utils::telemetry::dumpIfDue({}, true);
+            if (utils::profiler::isEnabled()) {
+                utils::profiler::exportChromeTrace(openxr_api_layer::localAppData / "trace.json");
+            }
+            return OpenXrApi::xrDestroySession(session);
+        }
+
         // Pre-enumerate swapchain images and remember textures
         XrResult xrCreateSwapchain(XrSession session,
                                    const XrSwapchainCreateInfo* createInfo,
                                    XrSwapchain* swapchain) override {
             const XrResult r = OpenXrApi::xrCreateSwapchain(session, createInfo, swapchain);
             if (XR_SUCCEEDED(r)) {
+                XrSwapchainCreateInfo info = *createInfo;
+                info.next = nullptr;
+                m_swapchainInfos.insert_or_assign(*swapchain, info);
+                m_swapchainSessions.insert_or_assign(*swapchain, session);
+                const float nativeScale = getSwapchainNativeScale(info);
+                m_swapchainNativeScales.insert_or_assign(*swapchain, nativeScale);
                 try {
                     auto sit = m_sessions.find(session);
+                    if (sit != m_sessions.end() && sit->second->worker) {
+                        SessionState* s = sit->second.get();
+                        const XrSwapchain handle = *swapchain;
+                        const bool upscaling = nativeScale > 1.0f;
+                        s->worker->post([s, handle, info, upscaling]() { warmUpSwapchain(s, handle, info, upscaling); });
+                    }
                     if (sit != m_sessions.end() && sit->second->appD3DDevice) {
                         // Only attempt D3D11 image enumeration when we know we're D3D11
                         std::vector<XrSwapchainImageD3D11KHR> images;
@@ -973,18 +2287,18 @@ namespace openxr_api_layer {
                             }
                         }
                     }
+                    if (sit != m_sessions.end() && sit->second->d3d12) {
+                        getSwapchainImages12(*swapchain);
+                    }
                 } catch (...) {
-                    ErrorLog("xrCreateSwapchain: exception during D3D11 image caching\n");
+                    ErrorLog("xrCreateSwapchain: exception during swapchain image caching\n");
                 }
             }
             return r;
         }
 
         XrResult xrDestroySwapchain(XrSwapchain swapchain) override {
-            // Cleanup bookkeeping
-            m_acquired.erase(swapchain);
-            m_lastReleased.erase(swapchain);
-            m_swapchainImages.erase(swapchain);
+            forgetSwapchain(swapchain);
             return OpenXrApi::xrDestroySwapchain(swapchain);
         }
 
@@ -992,6 +2306,7 @@ namespace openxr_api_layer {
         XrResult xrAcquireSwapchainImage(XrSwapchain swapchain,
                                          const XrSwapchainImageAcquireInfo* acquireInfo,
                                          uint32_t* index) override {
+            utils::profiler::Scope scope("xrAcquireSwapchainImage");
             const XrResult r = OpenXrApi::xrAcquireSwapchainImage(swapchain, acquireInfo, index);
             if (XR_SUCCEEDED(r)) {
                 TraceLoggingWrite(g_traceProvider, "xrAcquireSwapchainImage", TLArg((int)*index, "Index"));
@@ -1002,6 +2317,7 @@ namespace openxr_api_layer {
 
         XrResult xrReleaseSwapchainImage(XrSwapchain swapchain,
                                          const XrSwapchainImageReleaseInfo* releaseInfo) override {
+            utils::profiler::Scope scope("xrReleaseSwapchainImage");
             const XrResult r = OpenXrApi::xrReleaseSwapchainImage(swapchain, releaseInfo);
             if (XR_SUCCEEDED(r)) {
                 auto& dq = m_acquired[swapchain];
@@ -1009,97 +2325,220 @@ namespace openxr_api_layer {
                     m_lastReleased[swapchain] = dq.front();
                     dq.pop_front();
                 }
-                Log(fmt::format("Swapchain {} released image index {}\n", (void*)swapchain, (int)m_lastReleased[swapchain].value_or(-1)));
             }
             return r;
         }
 
-        // Minimal hook to serialize, then process the most recent color swapchain image via CAS.
+        // Serialize, then process the most recent image of every swapchain referenced by the projection layers.
         XrResult xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) override {
+            utils::profiler::Scope scope("xrEndFrame");
+            const auto endFrameStart = std::chrono::steady_clock::now();
+            const XrFrameEndInfo* chainFrameEndInfo = frameEndInfo;
+            if (m_dynamicResolution) {
+                updateRenderScale(frameEndInfo);
+            }
             try {
                 auto it = m_sessions.find(session);
                 if (it != m_sessions.end()) {
-                    if (it->second->composition) {
+                    reloadConfigIfChanged(it->second.get());
+                    const uint32_t evicted = m_texturePool.beginFrame() + m_texturePool12.beginFrame();
+                    for (uint32_t i = 0; i < evicted; i++) {
+                        utils::telemetry::increment(utils::telemetry::Event::PoolEviction);
+                    }
+                    adoptWarmTextures(it->second.get());
+                    if (it->second->recorder) {
+                        it->second->recorder->invalidate();
+                    }
+                    // D3D12 sessions record on the application's queue and need no serialization with the runtime.
+                    const bool useComposition = !it->second->d3d12 && getComposition(it->second.get(), session);
+                    if (useComposition) {
                         it->second->composition->serializePreComposition();
                     }
-                Log(fmt::format("xrEndFrame: intercept, layerCount={}\n", frameEndInfo ? (int)frameEndInfo->layerCount : 0));
-                if (frameEndInfo && frameEndInfo->layerCount > 0) {
-                    const XrCompositionLayerBaseHeader* base0 = frameEndInfo->layers[0];
-                    DebugLog(fmt::format("FirstLayer type={} (no flags in this OpenXR header)\n", base0 ? (int)base0->type : -1));
-                }
 
-        // Process first projection layer found; apply to all its views (L/R)
-                    if (frameEndInfo && frameEndInfo->layerCount > 0) {
-                        const XrCompositionLayerProjection* projLayer = nullptr;
-                        for (uint32_t li = 0; li < frameEndInfo->layerCount; ++li) {
-                            const XrCompositionLayerBaseHeader* base = frameEndInfo->layers[li];
-                            if (base && base->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
-                                projLayer = reinterpret_cast<const XrCompositionLayerProjection*>(base);
-                                break;
-                            }
+                    // Collect the work for all views of all projection layers. Several views (or layers) may reference
+                    // the same swapchain image and slice, the planner makes sure each texel is only processed once.
+                    m_framePlanner.reset();
+                    m_viewOutputs.clear();
+                    bool hasProjectionLayer = false;
+                    for (uint32_t li = 0; frameEndInfo && li < frameEndInfo->layerCount; ++li) {
+                        const XrCompositionLayerBaseHeader* base = frameEndInfo->layers[li];
+                        if (!base || base->type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                            utils::telemetry::increment(utils::telemetry::Event::LayerIgnored);
+                            continue;
                         }
-            if (projLayer && projLayer->viewCount > 0) {
-                            for (uint32_t vi = 0; vi < projLayer->viewCount; ++vi) {
-                                const XrSwapchainSubImage& sub = projLayer->views[vi].subImage;
-                                auto lastIt = m_lastReleased.find(sub.swapchain);
-                                if (lastIt != m_lastReleased.end() && lastIt->second.has_value()) {
-                                    const uint32_t idx = lastIt->second.value();
-                                    auto imgIt = m_swapchainImages.find(sub.swapchain);
-                        if (imgIt == m_swapchainImages.end()) {
-                            // Fallback: enumerate images now (D3D11 only)
-                            std::vector<XrSwapchainImageD3D11KHR> images;
-                            uint32_t count = 0;
-                            xrEnumerateSwapchainImages(sub.swapchain, 0, &count, nullptr);
-                            if (count > 0) {
-                                images.resize(count);
-                                for (auto& img : images) img.type = XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR, img.next = nullptr;
-                                if (XR_SUCCEEDED(xrEnumerateSwapchainImages(sub.swapchain,
-                                                                            count,
-                                                                            &count,
-                                                                            reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())))) {
-                                    std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> texList;
-                                    texList.reserve(count);
-                                    for (auto& img : images) texList.emplace_back(img.texture);
-                                    m_swapchainImages.insert_or_assign(sub.swapchain, std::move(texList));
-                                    Log(fmt::format("Cached {} D3D11 swapchain images for {} (fallback)\n", count, (void*)sub.swapchain));
-                                }
+                        hasProjectionLayer = true;
+
+                        const XrCompositionLayerProjection* projLayer =
+                            reinterpret_cast<const XrCompositionLayerProjection*>(base);
+                        for (uint32_t vi = 0; vi < projLayer->viewCount; ++vi) {
+                            const XrSwapchainSubImage& sub = projLayer->views[vi].subImage;
+                            ViewOutput& view = m_viewOutputs.emplace_back();
+                            view.swapchain = sub.swapchain;
+                            view.arraySlice = sub.imageArrayIndex;
+                            auto lastIt = m_lastReleased.find(sub.swapchain);
+                            if (lastIt == m_lastReleased.end() || !lastIt->second.has_value()) {
+                                utils::telemetry::increment(utils::telemetry::Event::NoReleasedImage);
+                                continue;
+                            }
+                            const uint32_t idx = lastIt->second.value();
+                            const auto imageSize = getImageSize(it->second.get(), sub.swapchain, idx);
+                            if (!imageSize) {
+                                continue;
+                            }
+
+                            // Resolve the "whole image" convention and clip to the texture.
+                            const auto [imageWidth, imageHeight] = *imageSize;
+                            utils::frameplan::WorkItem item;
+                            item.swapchain = (uint64_t)sub.swapchain;
+                            item.imageIndex = idx;
+                            item.arraySlice = sub.imageArrayIndex;
+                            item.rect.x = std::max(sub.imageRect.offset.x, 0);
+                            item.rect.y = std::max(sub.imageRect.offset.y, 0);
+                            item.rect.width = sub.imageRect.extent.width ? sub.imageRect.extent.width : imageWidth;
+                            item.rect.height = sub.imageRect.extent.height ? sub.imageRect.extent.height : imageHeight;
+                            item.rect.width = std::min(item.rect.width, imageWidth - item.rect.x);
+                            item.rect.height = std::min(item.rect.height, imageHeight - item.rect.y);
+                            m_framePlanner.add(item);
+                            if (item.rect.empty()) {
+                                continue;
+                            }
+
+                            view.rect = {{item.rect.x, item.rect.y}, {item.rect.width, item.rect.height}};
+                            if (m_upscaleEnabled && vi < m_recommendedViewSizes.size()) {
+                                const RecommendedViewSize& size = m_recommendedViewSizes[vi];
+                                view.scaleX = std::max((float)size.nativeWidth / item.rect.width, 1.0f);
+                                view.scaleY = std::max((float)size.nativeHeight / item.rect.height, 1.0f);
                             }
-                            imgIt = m_swapchainImages.find(sub.swapchain);
                         }
-                                    if (imgIt != m_swapchainImages.end() && idx < imgIt->second.size()) {
-                                        Log(fmt::format("CAS: processing view {} image index {} ({}x{})\n", (int)vi, idx, sub.imageRect.extent.width, sub.imageRect.extent.height));
-                                        // Guard against null textures
-                                    if (imgIt->second[idx]) {
-                                dispatchCas(m_sessions[session].get(), sub.swapchain, imgIt->second[idx].Get(), sub, m_tempPool);
-                                        } else {
-                        Log("CAS: null D3D11 texture pointer; skipping.\n");
-                                        }
-                        } else {
-                            Log("CAS: no cached images or index out of range; skipping.\n");
-                                    }
-                    } else {
-                        Log("CAS: no last-released image to process.\n");
                     }
+                    if (!hasProjectionLayer) {
+                        utils::telemetry::increment(utils::telemetry::Event::NoProjectionLayer);
+                    }
+
+                    const auto& workItems = m_framePlanner.build();
+                    if (workItems.size() != m_framePlanner.getSubmittedCount()) {
+                        DebugLog(fmt::format("CAS: planned {} work items from {} views\n",
+                                             workItems.size(),
+                                             m_framePlanner.getSubmittedCount()));
+                    }
+                    for (auto& [appSwapchain, target] : m_outputTargets) {
+                        target.submit = false;
+                        target.acquireFailed = false;
+                    }
+                    const bool ready = !workItems.empty() && it->second->ready.load(std::memory_order_acquire);
+                    const bool preserveState = ready && !it->second->d3d12;
+                    if (preserveState) {
+                        saveApplicationState(it->second.get());
+                    }
+                    auto restoreState = wil::scope_exit([&]() {
+                        if (preserveState) {
+                            restoreApplicationState(it->second.get());
+                        }
+                    });
+                    bool allProcessed = true;
+                    if (it->second->d3d12) {
+                        allProcessed = processViews12(it->second.get(), workItems);
+                    } else {
+                        auto releaseResolved =
+                            wil::scope_exit([&]() { releaseResolvedSlices(it->second.get(), m_texturePool); });
+                        for (const auto& item : workItems) {
+                            XrSwapchainSubImage sub{};
+                            sub.swapchain = (XrSwapchain)item.swapchain;
+                            sub.imageArrayIndex = item.arraySlice;
+                            sub.imageRect.offset = {item.rect.x, item.rect.y};
+                            sub.imageRect.extent = {item.rect.width, item.rect.height};
+                            auto infoIt = m_swapchainInfos.find(sub.swapchain);
+                            if (infoIt == m_swapchainInfos.end()) {
+                                continue;
                             }
-                        } else {
-                Log("No projection layer found; CAS skipped\n");
-                if (frameEndInfo && frameEndInfo->layerCount > 0) {
-                    for (uint32_t li = 0; li < frameEndInfo->layerCount; ++li) {
-                        const XrCompositionLayerBaseHeader* base = frameEndInfo->layers[li];
-                        DebugLog(fmt::format("Layer[{}] type={} (no flags in this OpenXR header)\n", (int)li, base ? (int)base->type : -1));
+
+                            // Multisampled images cannot receive the result, and upscaled images do not fit in the
+                            // application swapchain: the result goes to a layer-owned swapchain instead.
+                            ID3D11Texture2D* source = m_swapchainImages[sub.swapchain][item.imageIndex].Get();
+                            const DXGI_FORMAT sourceFormat = (DXGI_FORMAT)infoIt->second.format;
+                            ID3D11Texture2D* destination = source;
+                            DXGI_FORMAT destinationFormat = sourceFormat;
+                            XrRect2Di outputRect = sub.imageRect;
+                            OutputTarget* target = nullptr;
+                            D3D11_TEXTURE2D_DESC td{};
+                            source->GetDesc(&td);
+                            if (td.SampleDesc.Count > 1 || isUpscaled(item)) {
+                                target = getOutputTarget(it->second.get(), session, sub.swapchain);
+                                if (!target) {
+                                    continue;
+                                }
+                                if (!target->acquiredImage && !target->acquireFailed) {
+                                    // First view of the swapchain in this frame.
+                                    placeViews(*target, sub.swapchain);
+                                    target->acquiredImage = target->swapchain->acquireImage();
+                                    target->submit = target->acquiredImage != nullptr;
+                                    if (!target->acquiredImage) {
+                                        utils::telemetry::increment(utils::telemetry::Event::NoOutputImage);
+                                        target->acquireFailed = true;
+                                    }
+                                }
+                                if (!target->acquiredImage) {
+                                    // The application swapchain is submitted unprocessed for this frame.
+                                    allProcessed = false;
+                                    continue;
+                                }
+                                outputRect = getOutputRect(*target, item);
+                                destination = target->acquiredImage->getApplicationTexture()
+                                                  ->getNativeTexture<utils::graphics::D3D11>();
+                                destinationFormat = (DXGI_FORMAT)target->swapchain->getFormatOnApplicationDevice();
+                            }
+
+                            const bool processed = dispatchCas(it->second.get(),
+                                                               sub.swapchain,
+                                                               source,
+                                                               sourceFormat,
+                                                               destination,
+                                                               destinationFormat,
+                                                               sub,
+                                                               outputRect,
+                                                               m_texturePool);
+                            allProcessed = allProcessed && processed;
+                            if (target) {
+                                target->submit = target->submit && processed;
+                            }
+                        }
                     }
-                }
+                    restoreState.reset();
+
+                    // Only substitute the output swapchains whose views were all processed.
+                    bool hasOutputLayers = false;
+                    for (auto& [appSwapchain, target] : m_outputTargets) {
+                        if (target.acquiredImage) {
+                            target.swapchain->releaseImage();
+                            target.acquiredImage = nullptr;
+                            hasOutputLayers = hasOutputLayers || target.submit;
                         }
                     }
+                    if (hasOutputLayers) {
+                        chainFrameEndInfo = substituteOutputLayers(frameEndInfo);
+                    }
 
-                    if (it->second->composition) {
+                    if (useComposition) {
                         it->second->composition->serializePostComposition();
                     }
+
+                    auto& stats = it->second->stats;
+                    if (workItems.empty()) {
+                        stats.framesSkipped[(uint32_t)utils::stats::SkipReason::NoImage]++;
+                    } else if (!ready) {
+                        stats.framesSkipped[(uint32_t)utils::stats::SkipReason::NotReady]++;
+                    } else if (!allProcessed) {
+                        stats.framesSkipped[(uint32_t)utils::stats::SkipReason::Failed]++;
+                    } else {
+                        stats.framesProcessed++;
+                    }
+                    publishStats(it->second.get(), endFrameStart);
+                    utils::telemetry::dumpIfDue(30s);
                 }
             } catch (...) {
                 ErrorLog("xrEndFrame: exception in layer processing\n");
             }
-            return OpenXrApi::xrEndFrame(session, frameEndInfo);
+            return OpenXrApi::xrEndFrame(session, chainFrameEndInfo);
         }
 
       private:
@@ -1107,6 +2546,447 @@ namespace openxr_api_layer {
             return systemId == m_systemId;
         }
 
+        // Complete the statistics of the frame with the CPU time of xrEndFrame() and the pool size, then publish them.
+        void publishStats(SessionState* state, std::chrono::steady_clock::time_point endFrameStart) {
+            auto& stats = state->stats;
+            const uint32_t cpuUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                       std::chrono::steady_clock::now() - endFrameStart)
+                                       .count();
+            stats.endFrameCpuUsLast = cpuUs;
+            stats.endFrameCpuUsTotal += cpuUs;
+            stats.endFrameCpuUsAverage = stats.endFrameCpuUsAverage > 0.0f
+                                             ? stats.endFrameCpuUsAverage + 0.1f * (cpuUs - stats.endFrameCpuUsAverage)
+                                             : (float)cpuUs;
+            stats.poolBytes = m_texturePool.getStats().bytes + m_texturePool12.getStats().bytes;
+            m_statsWriter.publish(stats);
+        }
+
+        // The composition framework is created once our xrCreateSession() has returned, so it is retrieved on first use.
+        utils::graphics::ICompositionFramework* getComposition(SessionState* state, XrSession session) {
+            if (!state->composition && m_compFactory) {
+                if (auto* comp = m_compFactory->getCompositionFramework(session)) {
+                    state->composition = std::shared_ptr<utils::graphics::ICompositionFramework>(
+                        comp, [](utils::graphics::ICompositionFramework*) {});
+                }
+            }
+            return state->composition.get();
+        }
+
+        // Move the temporary textures created by the worker thread into the pool, unless their swapchain is gone.
+        void adoptWarmTextures(SessionState* state) {
+            std::unique_lock lock(state->objectsMutex, std::try_to_lock);
+            if (!lock || state->warmTextures.empty()) {
+                return;
+            }
+            for (auto& entry : state->warmTextures) {
+                // Dropped if the pool already has an idle entry for the key.
+                uint32_t id = 0;
+                bool created = false;
+                if (TempTextures* textures =
+                        m_texturePool.acquire(entry.key, getTempTexturesBytes(entry.key), id, created)) {
+                    if (created) {
+                        *textures = std::move(entry.textures);
+                    }
+                    m_texturePool.release(id);
+                }
+            }
+            state->warmTextures.clear();
+        }
+
+        bool isUpscaling() const {
+            return m_upscaleEnabled && m_upscaleFactor < 1.0f;
+        }
+
+        // The ratio of the native resolution to the resolution of a new application swapchain. A swapchain fitting the
+        // native resolution of the views is not upscaled. Otherwise, it is assumed to be sized after the reduced
+        // resolution reported to the application.
+        float getSwapchainNativeScale(const XrSwapchainCreateInfo& info) const {
+            uint32_t nativeWidth = 0;
+            uint32_t nativeHeight = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            for (const RecommendedViewSize& size : m_recommendedViewSizes) {
+                nativeWidth = std::max(nativeWidth, size.nativeWidth);
+                nativeHeight = std::max(nativeHeight, size.nativeHeight);
+                width = std::max(width, size.width);
+                height = std::max(height, size.height);
+            }
+            if (!m_upscaleEnabled || !width || !height || (width >= nativeWidth && height >= nativeHeight) ||
+                (info.width >= nativeWidth && info.height >= nativeHeight)) {
+                return 1.0f;
+            }
+            return std::max((float)nativeWidth / width, (float)nativeHeight / height);
+        }
+
+        // Drop the bookkeeping of an application swapchain, and its output swapchain.
+        void forgetSwapchain(XrSwapchain swapchain) {
+            m_acquired.erase(swapchain);
+            m_lastReleased.erase(swapchain);
+            m_swapchainImages.erase(swapchain);
+            m_swapchainImages12.erase(swapchain);
+            m_swapchainSessions.erase(swapchain);
+            auto infoIt = m_swapchainInfos.find(swapchain);
+            if (infoIt != m_swapchainInfos.end()) {
+                // The temporary textures are shared, they age out of the pool once unused.
+                for (uint32_t slice = 0; slice < infoIt->second.arraySize; slice++) {
+                    for (auto& [session, state] : m_sessions) {
+                        for (uint32_t slot = 0; slot < (uint32_t)ConstantsSlot::Count; slot++) {
+                            state->constants.erase(makeConstantsKey(swapchain, slice, (ConstantsSlot)slot));
+                        }
+                    }
+                }
+                m_swapchainInfos.erase(infoIt);
+            }
+            m_outputTargets.erase(swapchain);
+            m_swapchainNativeScales.erase(swapchain);
+        }
+
+        // Feed the timing of the frame being submitted to the dynamic resolution controller. The frame time is the
+        // time the application spent between xrBeginFrame() and xrEndFrame(), or the time since the previous frame if
+        // frames were dropped. The new scale applies to the following frames and to the next view configuration query.
+        void updateRenderScale(const XrFrameEndInfo* frameEndInfo) {
+            if (m_frameBeginTime == std::chrono::steady_clock::time_point{} || m_displayPeriodMs <= 0.0) {
+                return;
+            }
+            const double busyTimeMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_frameBeginTime).count();
+            const float previousScale = m_upscaleFactor;
+            const bool wasFollowed = m_dynamicResolution->isFollowed();
+            m_upscaleFactor = m_dynamicResolution->update(
+                std::max(busyTimeMs, m_droppedFrameTimeMs), m_displayPeriodMs, getRenderedScale(frameEndInfo));
+            if (m_dynamicResolution->isFollowed() != wasFollowed) {
+                Log(m_dynamicResolution->isFollowed()
+                        ? "CAS upscale: the application changed its resolution, resuming dynamic resolution\n"
+                        : "CAS upscale: the application does not follow the recommended resolution\n");
+            }
+            if (m_upscaleFactor != previousScale) {
+                Log(fmt::format("CAS upscale: render scale {:.3f} -> {:.3f} (utilization {:.2f})\n",
+                                previousScale,
+                                m_upscaleFactor,
+                                m_dynamicResolution->getUtilization()));
+            }
+        }
+
+        // The scale the application rendered a frame at: the largest ratio of a projection view to the native
+        // resolution of the view, or 0 if unknown.
+        float getRenderedScale(const XrFrameEndInfo* frameEndInfo) const {
+            float scale = 0.0f;
+            for (uint32_t li = 0; frameEndInfo && li < frameEndInfo->layerCount; ++li) {
+                const XrCompositionLayerBaseHeader* base = frameEndInfo->layers[li];
+                if (!base || base->type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                    continue;
+                }
+                const XrCompositionLayerProjection* projLayer =
+                    reinterpret_cast<const XrCompositionLayerProjection*>(base);
+                for (uint32_t vi = 0; vi < projLayer->viewCount && vi < m_recommendedViewSizes.size(); ++vi) {
+                    const XrExtent2Di& extent = projLayer->views[vi].subImage.imageRect.extent;
+                    const RecommendedViewSize& size = m_recommendedViewSizes[vi];
+                    if (extent.width > 0 && extent.height > 0 && size.nativeWidth && size.nativeHeight) {
+                        scale = std::max({scale,
+                                          (float)extent.width / size.nativeWidth,
+                                          (float)extent.height / size.nativeHeight});
+                    }
+                }
+            }
+            return scale;
+        }
+
+        // Whether a work item covers views rendered under their native resolution.
+        bool isUpscaled(const utils::frameplan::WorkItem& item) const {
+            for (const ViewOutput& view : m_viewOutputs) {
+                if (isInWorkItem(view, item) && view.isUpscaled()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static bool isInWorkItem(const ViewOutput& view, const utils::frameplan::WorkItem& item) {
+            return view.swapchain == (XrSwapchain)item.swapchain && view.arraySlice == item.arraySlice &&
+                   view.rect.extent.width > 0 && view.rect.offset.x >= item.rect.x &&
+                   view.rect.offset.y >= item.rect.y &&
+                   view.rect.offset.x + view.rect.extent.width <= item.rect.right() &&
+                   view.rect.offset.y + view.rect.extent.height <= item.rect.bottom();
+        }
+
+        // Place the views of an application swapchain in its output swapchain, at their native resolution. The offsets
+        // are scaled alike, so that views packed at the resolution they were rendered at stay packed. Views laid out
+        // for a larger resolution than they were rendered at (eg: within a swapchain of the recommended resolution)
+        // would not fit, they keep the layout of the application swapchain instead.
+        void placeViews(const OutputTarget& target, XrSwapchain swapchain) {
+            for (ViewOutput& view : m_viewOutputs) {
+                if (view.swapchain != swapchain || view.rect.extent.width <= 0) {
+                    continue;
+                }
+                XrRect2Di rect = scaleRect(view.rect, view.scaleX, view.scaleY);
+                if (rect.offset.x + rect.extent.width > (int32_t)target.width ||
+                    rect.offset.y + rect.extent.height > (int32_t)target.height) {
+                    rect.offset = scaleRect(view.rect, target.nativeScale, target.nativeScale).offset;
+                }
+                rect.extent.width = std::max(std::min(rect.extent.width, (int32_t)target.width - rect.offset.x), 0);
+                rect.extent.height = std::max(std::min(rect.extent.height, (int32_t)target.height - rect.offset.y), 0);
+                view.outputRect = rect;
+            }
+        }
+
+        // The rect of the output swapchain written by a work item: the union of the output rects of its views.
+        XrRect2Di getOutputRect(const OutputTarget& target, const utils::frameplan::WorkItem& item) const {
+            utils::frameplan::Rect output;
+            for (const ViewOutput& view : m_viewOutputs) {
+                if (!isInWorkItem(view, item)) {
+                    continue;
+                }
+                const utils::frameplan::Rect rect{view.outputRect.offset.x,
+                                                  view.outputRect.offset.y,
+                                                  view.outputRect.extent.width,
+                                                  view.outputRect.extent.height};
+                output = output.empty() ? rect : utils::frameplan::merge(output, rect);
+            }
+            if (output.empty()) {
+                return scaleRect({{item.rect.x, item.rect.y}, {item.rect.width, item.rect.height}},
+                                 target.nativeScale,
+                                 target.nativeScale);
+            }
+            return {{output.x, output.y}, {output.width, output.height}};
+        }
+
+        // Return the layer-owned swapchain receiving the processed image of an application swapchain, creating it on
+        // first use. It is created at the native resolution once, the dynamic resolution only changes the rects written
+        // to it. A failure to create it is remembered so that it is only reported once.
+        OutputTarget* getOutputTarget(SessionState* state, XrSession session, XrSwapchain swapchain) {
+            auto targetIt = m_outputTargets.find(swapchain);
+            if (targetIt != m_outputTargets.end()) {
+                return targetIt->second.swapchain ? &targetIt->second : nullptr;
+            }
+
+            OutputTarget& target = m_outputTargets[swapchain];
+            auto* composition = getComposition(state, session);
+            auto infoIt = m_swapchainInfos.find(swapchain);
+            if (!composition || infoIt == m_swapchainInfos.end()) {
+                ErrorLog("CAS: no composition framework for output swapchain; skipping\n");
+                return nullptr;
+            }
+
+            XrSwapchainCreateInfo info = infoIt->second;
+            info.createFlags = 0;
+            info.usageFlags |= XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+            info.sampleCount = 1;
+            info.mipCount = 1;
+            auto nativeScaleIt = m_swapchainNativeScales.find(swapchain);
+            target.nativeScale = nativeScaleIt != m_swapchainNativeScales.end() ? nativeScaleIt->second : 1.0f;
+            info.width = (uint32_t)std::lround(info.width * target.nativeScale);
+            info.height = (uint32_t)std::lround(info.height * target.nativeScale);
+            if (state->runtimeOutputFormat) {
+                // The last pass converts to the preferred format, provided that it can store to it.
+                const utils::formats::FormatInfo* formatInfo = utils::formats::getFormatInfo((DXGI_FORMAT)info.format);
+                const int64_t preferredFormat = composition->getPreferredSwapchainFormatOnApplicationDevice(
+                    XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT, formatInfo && formatInfo->isSRGB);
+                const utils::formats::FormatInfo* preferredInfo =
+                    utils::formats::getFormatInfo((DXGI_FORMAT)preferredFormat);
+                if (formatInfo && preferredInfo && getStorePlan(state, *preferredInfo)) {
+                    info.format = preferredFormat;
+                } else {
+                    Log(fmt::format("CAS: cannot convert to the runtime's preferred format {}, keeping format {}\n",
+                                    preferredFormat,
+                                    info.format));
+                }
+            }
+            try {
+                target.swapchain = composition->createSwapchain(info, utils::graphics::SwapchainMode::Submit);
+            } catch (std::exception& exc) {
+                ErrorLog(fmt::format("CAS: failed to create output swapchain: {}\n", exc.what()));
+                return nullptr;
+            }
+            target.width = info.width;
+            target.height = info.height;
+            const utils::graphics::SwapchainStats swapchainStats = target.swapchain->getStats();
+            Log(fmt::format("CAS: created {}x{} output swapchain (format {}) for swapchain {} ({}x{}, {} samples, {} "
+                            "shared and {} bounce-buffered images)\n",
+                            info.width,
+                            info.height,
+                            info.format,
+                            (void*)swapchain,
+                            infoIt->second.width,
+                            infoIt->second.height,
+                            infoIt->second.sampleCount,
+                            swapchainStats.sharedImages,
+                            swapchainStats.bounceBufferedImages));
+            return &target;
+        }
+
+        // Submit the output swapchains in place of the application swapchains they were processed from, with the
+        // image rects moved to the output resolution. The patched structures are kept in members so that they live
+        // until the upstream xrEndFrame() returns.
+        const XrFrameEndInfo* substituteOutputLayers(const XrFrameEndInfo* frameEndInfo) {
+            uint32_t totalViewCount = 0;
+            for (uint32_t li = 0; li < frameEndInfo->layerCount; ++li) {
+                const XrCompositionLayerBaseHeader* base = frameEndInfo->layers[li];
+                if (base && base->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                    totalViewCount += reinterpret_cast<const XrCompositionLayerProjection*>(base)->viewCount;
+                }
+            }
+
+            // Reserve upfront: the layers point into these vectors.
+            m_patchedLayers.assign(frameEndInfo->layers, frameEndInfo->layers + frameEndInfo->layerCount);
+            m_patchedProjections.clear();
+            m_patchedProjections.reserve(frameEndInfo->layerCount);
+            m_patchedViews.clear();
+            m_patchedViews.reserve(totalViewCount);
+            size_t viewIndex = 0;
+            for (uint32_t li = 0; li < frameEndInfo->layerCount; ++li) {
+                const XrCompositionLayerBaseHeader* base = frameEndInfo->layers[li];
+                if (!base || base->type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+                    continue;
+                }
+
+                const XrCompositionLayerProjection* projLayer =
+                    reinterpret_cast<const XrCompositionLayerProjection*>(base);
+                const size_t firstView = m_patchedViews.size();
+                bool patched = false;
+                for (uint32_t vi = 0; vi < projLayer->viewCount; ++vi, ++viewIndex) {
+                    XrCompositionLayerProjectionView view = projLayer->views[vi];
+                    auto targetIt = m_outputTargets.find(view.subImage.swapchain);
+                    if (targetIt != m_outputTargets.end() && targetIt->second.submit) {
+                        const OutputTarget& target = targetIt->second;
+                        view.subImage.swapchain = target.swapchain->getSwapchainHandle();
+                        const ViewOutput* output =
+                            viewIndex < m_viewOutputs.size() ? &m_viewOutputs[viewIndex] : nullptr;
+                        view.subImage.imageRect =
+                            output && output->rect.extent.width > 0
+                                ? output->outputRect
+                                : scaleRect(view.subImage.imageRect, target.nativeScale, target.nativeScale);
+                        patched = true;
+                    }
+                    m_patchedViews.push_back(view);
+                }
+                if (!patched) {
+                    m_patchedViews.resize(firstView);
+                    continue;
+                }
+
+                XrCompositionLayerProjection patchedLayer = *projLayer;
+                patchedLayer.views = m_patchedViews.data() + firstView;
+                m_patchedProjections.push_back(patchedLayer);
+                m_patchedLayers[li] = reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_patchedProjections.back());
+            }
+
+            m_patchedFrameEndInfo = *frameEndInfo;
+            m_patchedFrameEndInfo.layers = m_patchedLayers.data();
+            return &m_patchedFrameEndInfo;
+        }
+
+        // Return the D3D11 textures of a swapchain, enumerating them on first use if they were not cached at creation.
+        const std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>>* getSwapchainImages(XrSwapchain swapchain) {
+            auto imgIt = m_swapchainImages.find(swapchain);
+            if (imgIt == m_swapchainImages.end()) {
+                std::vector<XrSwapchainImageD3D11KHR> images;
+                uint32_t count = 0;
+                xrEnumerateSwapchainImages(swapchain, 0, &count, nullptr);
+                if (count > 0) {
+                    images.resize(count);
+                    for (auto& img : images) img.type = XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR, img.next = nullptr;
+                    if (XR_SUCCEEDED(xrEnumerateSwapchainImages(
+                            swapchain, count, &count, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())))) {
+                        std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>> texList;
+                        texList.reserve(count);
+                        for (auto& img : images) texList.emplace_back(img.texture);
+                        m_swapchainImages.insert_or_assign(swapchain, std::move(texList));
+                        Log(fmt::format("Cached {} D3D11 swapchain images for {} (fallback)\n", count, (void*)swapchain));
+                    }
+                }
+                imgIt = m_swapchainImages.find(swapchain);
+            }
+            return imgIt != m_swapchainImages.end() ? &imgIt->second : nullptr;
+        }
+
+        // Same for the D3D12 textures of a swapchain.
+        const std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>* getSwapchainImages12(XrSwapchain swapchain) {
+            auto imgIt = m_swapchainImages12.find(swapchain);
+            if (imgIt == m_swapchainImages12.end()) {
+                std::vector<XrSwapchainImageD3D12KHR> images;
+                uint32_t count = 0;
+                xrEnumerateSwapchainImages(swapchain, 0, &count, nullptr);
+                if (count > 0) {
+                    images.resize(count, {XR_TYPE_SWAPCHAIN_IMAGE_D3D12_KHR});
+                    if (XR_SUCCEEDED(xrEnumerateSwapchainImages(
+                            swapchain, count, &count, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())))) {
+                        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> texList;
+                        texList.reserve(count);
+                        for (auto& img : images) texList.emplace_back(img.texture);
+                        m_swapchainImages12.insert_or_assign(swapchain, std::move(texList));
+                        Log(fmt::format("Cached {} D3D12 swapchain images for {}\n", count, (void*)swapchain));
+                    }
+                }
+                imgIt = m_swapchainImages12.find(swapchain);
+            }
+            return imgIt != m_swapchainImages12.end() ? &imgIt->second : nullptr;
+        }
+
+        // Return the size of an image of an application swapchain, or nullopt (counting why) if it cannot be used.
+        std::optional<std::pair<int32_t, int32_t>> getImageSize(SessionState* state,
+                                                                XrSwapchain swapchain,
+                                                                uint32_t index) {
+            if (state->d3d12) {
+                const auto* images = getSwapchainImages12(swapchain);
+                if (!images || index >= images->size()) {
+                    utils::telemetry::increment(utils::telemetry::Event::ImageIndexOutOfRange);
+                    return std::nullopt;
+                }
+                if (!(*images)[index]) {
+                    utils::telemetry::increment(utils::telemetry::Event::NullTexture);
+                    return std::nullopt;
+                }
+                const D3D12_RESOURCE_DESC desc = (*images)[index]->GetDesc();
+                return std::make_pair((int32_t)desc.Width, (int32_t)desc.Height);
+            }
+            const auto* images = getSwapchainImages(swapchain);
+            if (!images || index >= images->size()) {
+                utils::telemetry::increment(utils::telemetry::Event::ImageIndexOutOfRange);
+                return std::nullopt;
+            }
+            if (!(*images)[index]) {
+                utils::telemetry::increment(utils::telemetry::Event::NullTexture);
+                return std::nullopt;
+            }
+            D3D11_TEXTURE2D_DESC td{};
+            (*images)[index]->GetDesc(&td);
+            return std::make_pair((int32_t)td.Width, (int32_t)td.Height);
+        }
+
+        // Record the passes of all the views of a D3D12 session in one command list, submitted to the application's
+        // queue. Only the first view is timed.
+        bool processViews12(SessionState* state, const std::vector<utils::frameplan::WorkItem>& workItems) {
+            if (!state->ready.load(std::memory_order_acquire)) {
+                for (size_t i = 0; i < workItems.size(); i++) {
+                    utils::telemetry::increment(utils::telemetry::Event::NotReady);
+                }
+                return false;
+            }
+            collectGpuTimings12(state);
+            state->d3d12->beginFrame();
+            bool allProcessed = true;
+            bool timing = true;
+            for (const auto& item : workItems) {
+                XrSwapchainSubImage sub{};
+                sub.swapchain = (XrSwapchain)item.swapchain;
+                sub.imageArrayIndex = item.arraySlice;
+                sub.imageRect.offset = {item.rect.x, item.rect.y};
+                sub.imageRect.extent = {item.rect.width, item.rect.height};
+                auto infoIt = m_swapchainInfos.find(sub.swapchain);
+                if (infoIt == m_swapchainInfos.end()) {
+                    allProcessed = false;
+                    continue;
+                }
+                ID3D12Resource* image = m_swapchainImages12[sub.swapchain][item.imageIndex].Get();
+                allProcessed =
+                    dispatchCas12(state, sub.swapchain, image, infoIt->second, sub, timing, m_texturePool12) &&
+                    allProcessed;
+                timing = false;
+            }
+            state->d3d12->endFrame();
+            return allProcessed;
+        }
+
         bool m_bypassApiLayer{false};
         XrSystemId m_systemId{XR_NULL_SYSTEM_ID};
         std::shared_ptr<utils::graphics::ICompositionFrameworkFactory> m_compFactory;
@@ -1114,7 +2994,50 @@ namespace openxr_api_layer {
         std::unordered_map<XrSwapchain, std::deque<uint32_t>> m_acquired;
         std::unordered_map<XrSwapchain, std::optional<uint32_t>> m_lastReleased;
         std::unordered_map<XrSwapchain, std::vector<Microsoft::WRL::ComPtr<ID3D11Texture2D>>> m_swapchainImages;
-        std::unordered_map<uint64_t, TempTextures> m_tempPool;
+        std::unordered_map<XrSwapchain, XrSwapchainCreateInfo> m_swapchainInfos;
+        utils::texturepool::Pool<TempTextures> m_texturePool;
+        std::unordered_map<XrSwapchain, std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>> m_swapchainImages12;
+        utils::texturepool::Pool<utils::d3d12passes::TempTextures> m_texturePool12;
+
+        // Statistics of the sessions, for external monitoring tools.
+        utils::stats::StatsWriter m_statsWriter;
+        uint64_t m_nextSessionId{1};
+        utils::frameplan::FramePlanner m_framePlanner;
+        std::unordered_map<XrSwapchain, OutputTarget> m_outputTargets;
+
+        // The views of the projection layers of the current frame, in submission order.
+        std::vector<ViewOutput> m_viewOutputs;
+
+        // The session of each application swapchain.
+        std::unordered_map<XrSwapchain, XrSession> m_swapchainSessions;
+
+        // The ratio of the native resolution to the resolution of each application swapchain.
+        std::unordered_map<XrSwapchain, float> m_swapchainNativeScales;
+
+        // The recommended resolution of each view: the one of the runtime, and the one reported to the application.
+        struct RecommendedViewSize {
+            uint32_t nativeWidth{0};
+            uint32_t nativeHeight{0};
+            uint32_t width{0};
+            uint32_t height{0};
+        };
+        std::vector<RecommendedViewSize> m_recommendedViewSizes;
+
+        // Upscale mode settings, read at instance creation.
+        bool m_upscaleEnabled{false};
+        float m_upscaleFactor{0.77f};
+
+        // Dynamic resolution, only present when enabled. m_upscaleFactor follows its output.
+        std::optional<utils::dynres::Controller> m_dynamicResolution;
+        double m_displayPeriodMs{0.0};
+        double m_droppedFrameTimeMs{0.0};
+        XrTime m_lastPredictedDisplayTime{0};
+        std::chrono::steady_clock::time_point m_frameBeginTime{};
+
+        XrFrameEndInfo m_patchedFrameEndInfo{};
+        std::vector<const XrCompositionLayerBaseHeader*> m_patchedLayers;
+        std::vector<XrCompositionLayerProjection> m_patchedProjections;
+        std::vector<XrCompositionLayerProjectionView> m_patchedViews;
     };
 
     // This method is required by the framework to instantiate your OpenXrApi implementation.
@@ -32,6 +32,8 @@
 
 // Standard library.
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdarg>
 #include <ctime>
 #define _USE_MATH_DEFINES
@@ -42,10 +44,14 @@
 #include <mutex>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <string>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace std::chrono_literals;
 
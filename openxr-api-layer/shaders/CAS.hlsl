@@ -6,12 +6,18 @@ cbuffer cb : register(b0) {
 };
 
 cbuffer cbDebug : register(b1) {
-    uint4 dbg0; // x=flags, y=offset.x, z=offset.y, w=extent.x
-    uint4 dbg1; // x=extent.y
+    uint4 dbg0; // x=flags, y=offset.x, z=offset.y, w=extent.x (output rect)
+    uint4 dbg1; // x=extent.y, y=input offset.x, z=input offset.y
 };
 
+// CAS_SCALING=1 builds the upscaling variant: the output rect is larger than the input rect and const0/const1 carry
+// the scale from CasSetup(). Otherwise both rects are the same and CAS only sharpens.
+#ifndef CAS_SCALING
+#define CAS_SCALING 0
+#endif
+
 Texture2D InputTexture : register(t0);
-RWTexture2D<float4> OutputTexture : register(u0);
+#include "Store.hlsli"
 
 #define A_GPU 1
 #define A_HLSL 1
@@ -19,10 +25,15 @@ RWTexture2D<float4> OutputTexture : register(u0);
 #include "ffx_a.h"
 #if 1
 // Provide loader hookup expected by ffx_cas.h
+// CasFilter() works on rect-relative coordinates, the input rect offset is applied here.
 AF3 CasLoad(ASU2 p) {
-    return InputTexture.Load(int3(p, 0)).rgb;
+    return InputTexture.Load(int3(p + ASU2(dbg1.yz), 0)).rgb;
 }
 void CasInput(inout AF1 r, inout AF1 g, inout AF1 b) {
+    AF3 c = DecodeColor(AF3(r, g, b));
+    r = c.r;
+    g = c.g;
+    b = c.b;
 }
 #endif
 #include "ffx_cas.h"
@@ -40,27 +51,28 @@ void mainCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_Group
     uint flags = 0u; // force disabled
 
     AF3 c;
-    bool sharpenOnly = true; // sharpen-only path
+    bool sharpenOnly = CAS_SCALING == 0;
 
     // Note: CAS expects (0..1) strength internally; if user sets >1 we rely on the CPU side to produce const0/const1 that reflect that magnitude.
-    CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    CasFilter(c.r, c.g, c.b, gxyLocal, const0, const1, sharpenOnly);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
     DrawOverlay(flags, gxyLocal, gxy, extent);
+    gxyLocal.x += 8u;
     gxy.x += 8u;
 
-    CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
-    DrawOverlay(flags, gxyLocal + AU2(8u, 0u), gxy, extent);
+    CasFilter(c.r, c.g, c.b, gxyLocal, const0, const1, sharpenOnly);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
+    DrawOverlay(flags, gxyLocal, gxy, extent);
+    gxyLocal.y += 8u;
     gxy.y += 8u;
 
-    CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
-    DrawOverlay(flags, gxyLocal + AU2(8u, 8u), gxy, extent);
+    CasFilter(c.r, c.g, c.b, gxyLocal, const0, const1, sharpenOnly);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
+    DrawOverlay(flags, gxyLocal, gxy, extent);
+    gxyLocal.x -= 8u;
     gxy.x -= 8u;
 
-    CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
-    DrawOverlay(flags, gxyLocal + AU2(0u, 8u), gxy, extent);
+    CasFilter(c.r, c.g, c.b, gxyLocal, const0, const1, sharpenOnly);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
+    DrawOverlay(flags, gxyLocal, gxy, extent);
 }
-
-
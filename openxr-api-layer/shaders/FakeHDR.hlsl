@@ -10,11 +10,11 @@ cbuffer cbFakeHDR : register(b0) {
 }
 
 Texture2D InputTexture : register(t0);
-RWTexture2D<float4> OutputTexture : register(u0);
+#include "Store.hlsli"
 
 static int clampi(int v, int lo, int hi) { return (v < lo) ? lo : (v > hi) ? hi : v; }
 
-float3 sampleAt(int2 p) { return InputTexture.Load(int3(p, 0)).rgb; }
+float3 sampleAt(int2 p) { return DecodeColor(InputTexture.Load(int3(p, 0)).rgb); }
 
 bool inside(uint2 q, uint2 off, uint2 ext) {
     return (q.x >= off.x) && (q.y >= off.y) && (q.x < off.x + ext.x) && (q.y < off.y + ext.y);
@@ -78,7 +78,7 @@ void mainCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_Group
         uint2 dst = dsts[i];
         if (inside(dst, offset, extent)) {
             float3 outc = processPixel(dst, minXY, maxXY, r1, r2, HDRPower);
-            OutputTexture[dst] = float4(saturate(outc), 1);
+            StoreOutput(dst, float4(saturate(outc), 1));
         }
     }
 }
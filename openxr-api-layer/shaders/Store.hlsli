@@ -0,0 +1,67 @@
+// Output store and color decoding shared by the post-processing passes.
+// STORE_MODE and COLOR_ENCODING select the permutation and must match utils::formats::StoreMode and
+// utils::formats::ColorEncoding. OUTPUT_ENCODING defaults to COLOR_ENCODING, it only differs in the last pass of a
+// chain writing to a destination of another format, which converts as it stores.
+
+#define STORE_MODE_TYPED 0
+#define STORE_MODE_PACKED_UNORM8 1
+#define STORE_MODE_PACKED_UNORM10 2
+
+#define COLOR_ENCODING_LINEAR 0
+#define COLOR_ENCODING_SRGB_FAST 1
+#define COLOR_ENCODING_SRGB_EXACT 2
+
+#ifndef STORE_MODE
+#define STORE_MODE STORE_MODE_TYPED
+#endif
+#ifndef COLOR_ENCODING
+#define COLOR_ENCODING COLOR_ENCODING_LINEAR
+#endif
+#ifndef OUTPUT_ENCODING
+#define OUTPUT_ENCODING COLOR_ENCODING
+#endif
+
+#if STORE_MODE == STORE_MODE_TYPED
+RWTexture2D<float4> OutputTexture : register(u0);
+#else
+// UINT view of the intermediate texture, used when the device cannot do typed UAV stores to the UNORM view.
+RWTexture2D<uint4> OutputTexture : register(u0);
+#endif
+
+// sRGB swapchains are read through UNORM views, so the passes must linearize the values they load and re-encode the
+// values they store. Both are no-ops in the linear permutation.
+float3 DecodeColor(float3 c) {
+#if COLOR_ENCODING == COLOR_ENCODING_SRGB_FAST
+    return c * c;
+#elif COLOR_ENCODING == COLOR_ENCODING_SRGB_EXACT
+    return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+#else
+    return c;
+#endif
+}
+
+float3 EncodeColor(float3 c) {
+#if OUTPUT_ENCODING == COLOR_ENCODING_SRGB_FAST
+    return sqrt(max(c, 0));
+#elif OUTPUT_ENCODING == COLOR_ENCODING_SRGB_EXACT
+    c = max(c, 0);
+    return c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+#else
+    return c;
+#endif
+}
+
+uint4 PackUnorm(float4 c, float4 maxValue) {
+    return uint4(saturate(c) * maxValue + 0.5);
+}
+
+void StoreOutput(uint2 pos, float4 c) {
+    c.rgb = EncodeColor(c.rgb);
+#if STORE_MODE == STORE_MODE_PACKED_UNORM8
+    OutputTexture[pos] = PackUnorm(c, float4(255, 255, 255, 255));
+#elif STORE_MODE == STORE_MODE_PACKED_UNORM10
+    OutputTexture[pos] = PackUnorm(c, float4(1023, 1023, 1023, 3));
+#else
+    OutputTexture[pos] = c;
+#endif
+}
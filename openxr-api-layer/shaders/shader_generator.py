@@ -0,0 +1,144 @@
+# MIT License
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this softwareand associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+#
+# The above copyright noticeand this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Compile every permutation of the post-processing shaders with fxc.exe and embed the bytecode into shaders.gen.h.
+# Usage: shader_generator.py [--release] [path to fxc.exe]
+# Without fxc.exe, the shaders are compiled at runtime instead, which is only allowed for non-release builds.
+import glob
+import itertools
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+cur_dir = os.path.abspath(os.path.dirname(__file__))
+out_file = os.path.join(cur_dir, 'shaders.gen.h')
+
+release = '--release' in sys.argv[1:]
+args = [arg for arg in sys.argv[1:] if arg != '--release']
+
+# Must match ShaderPass, utils::formats::StoreMode and utils::formats::ColorEncoding in the layer.
+passes = [('CAS', True), ('FakeHDR', False), ('Levels', False)]
+store_modes = [0, 1, 2]
+encodings = [0, 1, 2]
+
+
+def make_key(pass_index, store_mode, encoding, output_encoding, scaling):
+    # Same as makeShaderKey() in layer.cpp.
+    return pass_index | (store_mode << 8) | (encoding << 16) | (output_encoding << 20) | (int(scaling) << 24)
+
+
+def find_fxc():
+    if args and os.path.isfile(args[0]):
+        return args[0]
+    fxc = shutil.which('fxc')
+    if fxc:
+        return fxc
+    # Latest Windows 10/11 SDK.
+    kits = os.path.join(os.environ.get('ProgramFiles(x86)', r'C:\Program Files (x86)'), 'Windows Kits', '10', 'bin')
+    candidates = sorted(glob.glob(os.path.join(kits, '10.*', 'x64', 'fxc.exe')), reverse=True)
+    return candidates[0] if candidates else None
+
+
+def write_header(entries):
+    lines = ['// *********** THIS FILE IS GENERATED - DO NOT EDIT ***********',
+             '// Generated by shader_generator.py from the sources in this folder.',
+             '',
+             '#pragma once',
+             '',
+             'namespace openxr_api_layer::shaders {',
+             '']
+    for name, key, bytecode in entries:
+        lines.append('    constexpr uint8_t %s[] = {' % name)
+        for i in range(0, len(bytecode), 16):
+            lines.append('        ' + ' '.join('0x%02x,' % b for b in bytecode[i:i + 16]))
+        lines.append('    };')
+        lines.append('')
+    lines.append('    struct EmbeddedShader {')
+    lines.append('        uint32_t key;')
+    lines.append('        const uint8_t* bytecode;')
+    lines.append('        size_t size;')
+    lines.append('    };')
+    lines.append('')
+    lines.append('    // Sorted by key.')
+    if entries:
+        lines.append('    constexpr EmbeddedShader EmbeddedShaders[] = {')
+        for name, key, bytecode in sorted(entries, key=lambda e: e[1]):
+            lines.append('        {0x%08x, %s, sizeof(%s)},' % (key, name, name))
+        lines.append('    };')
+        lines.append('    constexpr size_t EmbeddedShaderCount = std::size(EmbeddedShaders);')
+    else:
+        lines.append('    constexpr const EmbeddedShader* EmbeddedShaders = nullptr;')
+        lines.append('    constexpr size_t EmbeddedShaderCount = 0;')
+    lines.append('')
+    lines.append('} // namespace openxr_api_layer::shaders')
+    content = '\n'.join(lines) + '\n'
+
+    # Do not touch the file when nothing changed, to avoid needless rebuilds.
+    if os.path.isfile(out_file):
+        with open(out_file, 'r') as f:
+            if f.read() == content:
+                return
+    with open(out_file, 'w') as f:
+        f.write(content)
+
+
+def main():
+    fxc = find_fxc()
+    if not fxc and release:
+        print('shader_generator.py: error: fxc.exe not found, release builds must embed the shaders')
+        return 1
+    if not fxc:
+        print('shader_generator.py: warning: fxc.exe not found, shaders will be compiled at runtime')
+        write_header([])
+        return 0
+
+    entries = []
+    with tempfile.TemporaryDirectory() as tmp:
+        for pass_index, (shader, has_scaling) in enumerate(passes):
+            # The output encoding differs from the input encoding when the last pass converts formats.
+            for store_mode, encoding, output_encoding in itertools.product(store_modes, encodings, encodings):
+                for scaling in ([False, True] if has_scaling else [False]):
+                    name = '%s_%d_%d_%d_%d' % (shader, store_mode, encoding, output_encoding, int(scaling))
+                    cso = os.path.join(tmp, name + '.cso')
+                    result = subprocess.run([fxc, '/nologo', '/T', 'cs_5_0', '/E', 'mainCS', '/O3',
+                                             '/D', 'STORE_MODE=%d' % store_mode,
+                                             '/D', 'COLOR_ENCODING=%d' % encoding,
+                                             '/D', 'OUTPUT_ENCODING=%d' % output_encoding,
+                                             '/D', 'CAS_SCALING=%d' % int(scaling),
+                                             '/Fo', cso,
+                                             os.path.join(cur_dir, shader + '.hlsl')],
+                                            capture_output=True, text=True)
+                    if result.returncode != 0:
+                        print(result.stdout + result.stderr)
+                        print('shader_generator.py: error: failed to compile %s' % name)
+                        return 1
+                    with open(cso, 'rb') as f:
+                        key = make_key(pass_index, store_mode, encoding, output_encoding, scaling)
+                        entries.append((name, key, f.read()))
+
+    write_header(entries)
+    print('shader_generator.py: embedded %d shader permutations' % len(entries))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -24,6 +24,7 @@
 
 #include "graphics.h"
 #include "log.h"
+#include "telemetry.h"
 
 #if defined(XR_USE_GRAPHICS_API_D3D11) || defined(XR_USE_GRAPHICS_API_D3D12)
 
@@ -62,7 +63,9 @@ namespace xr {
 namespace {
 
     using namespace openxr_api_layer::log;
+    using namespace openxr_api_layer::utils;
     using namespace openxr_api_layer::utils::graphics;
+    using namespace openxr_api_layer::utils::timeline;
 
     bool isSRGBFormat(DXGI_FORMAT format) {
         return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
@@ -76,23 +79,49 @@ namespace {
                format == DXGI_FORMAT_D32_FLOAT || format == DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
     }
 
+    // Only meant for accounting the copies, formats not usable for swapchains are approximated.
+    uint64_t getBytesPerPixel(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            return 16;
+        case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+            return 8;
+        case DXGI_FORMAT_D16_UNORM:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+    constexpr uint32_t NoImage = ~0u;
+
     struct SwapchainImage : ISwapchainImage {
         SwapchainImage(std::shared_ptr<IGraphicsTexture> textureOnApplicationDevice,
                        std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice,
-                       uint32_t index)
+                       uint32_t index,
+                       FenceTimeline* timeline)
             : m_textureOnApplicationDevice(textureOnApplicationDevice), m_textureForRead(textureOnCompositionDevice),
-              m_textureForWrite(textureOnCompositionDevice), m_index(index) {
+              m_textureForWrite(textureOnCompositionDevice), m_index(index), m_timeline(timeline) {
         }
 
         IGraphicsTexture* getApplicationTexture() const override {
+            m_timeline->waitForComposition();
             return m_textureOnApplicationDevice.get();
         }
 
         IGraphicsTexture* getTextureForRead() const override {
+            m_timeline->waitForApplication();
+            m_timeline->markCompositionWork();
             return m_textureForRead.get();
         }
 
         IGraphicsTexture* getTextureForWrite() const override {
+            m_timeline->waitForApplication();
+            m_timeline->markCompositionWork();
             return m_textureForWrite.get();
         }
 
@@ -104,6 +133,7 @@ namespace {
         const std::shared_ptr<IGraphicsTexture> m_textureForRead;
         const std::shared_ptr<IGraphicsTexture> m_textureForWrite;
         const uint32_t m_index;
+        FenceTimeline* const m_timeline;
     };
 
     struct SubmittableSwapchain : ISwapchain {
@@ -113,12 +143,13 @@ namespace {
                              const XrSwapchainCreateInfo& infoOnApplicationDevice,
                              IGraphicsDevice* applicationDevice,
                              IGraphicsDevice* compositionDevice,
+                             std::shared_ptr<FenceTimeline> timeline,
                              SwapchainMode mode,
                              std::optional<bool> overrideShareable = {},
                              bool hasOwnership = true)
             : m_swapchain(swapchain), m_infoOnCompositionDevice(infoOnApplicationDevice),
               m_formatOnApplicationDevice(infoOnApplicationDevice.format), m_applicationDevice(applicationDevice),
-              m_compositionDevice(compositionDevice),
+              m_compositionDevice(compositionDevice), m_timeline(timeline),
               m_accessForRead((mode & SwapchainMode::Read) == SwapchainMode::Read),
               m_accessForWrite((mode & SwapchainMode::Write) == SwapchainMode::Write) {
             TraceLocalActivity(local);
@@ -177,15 +208,18 @@ namespace {
             }
 
             // Make the images available on the composition device.
+            std::string bounceReason = overrideShareable.value_or(true) ? "not shareable" : "shareability overridden";
             uint32_t index = 0;
             for (std::shared_ptr<IGraphicsTexture>& textureOnApplicationDevice : textures) {
                 std::unique_ptr<SwapchainImage> image;
+                std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice;
                 if (overrideShareable.value_or(true) && textureOnApplicationDevice->isShareable()) {
-                    const std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice =
-                        m_compositionDevice->openTexture(textureOnApplicationDevice->getTextureHandle(),
-                                                         m_infoOnCompositionDevice);
-                    image =
-                        std::make_unique<SwapchainImage>(textureOnApplicationDevice, textureOnCompositionDevice, index);
+                    textureOnCompositionDevice =
+                        tryOpenOnCompositionDevice(textureOnApplicationDevice.get(), bounceReason);
+                }
+                if (textureOnCompositionDevice) {
+                    image = std::make_unique<SwapchainImage>(
+                        textureOnApplicationDevice, textureOnCompositionDevice, index, m_timeline.get());
                 } else {
                     // If the swapchain image isn't shareable, we will need to create a copy accessible on both the
                     // application and composition device, and make sure to perform copy operations as needed.
@@ -197,18 +231,37 @@ namespace {
                             m_bounceBufferOnCompositionDevice->getTextureHandle(), infoOnApplicationDevice);
                     }
                     image = std::make_unique<SwapchainImage>(
-                        textureOnApplicationDevice, m_bounceBufferOnCompositionDevice, index);
+                        textureOnApplicationDevice, m_bounceBufferOnCompositionDevice, index, m_timeline.get());
                 }
+                m_isBounceBuffered.push_back(!textureOnCompositionDevice);
 
-                TraceLoggingWriteTagged(local, "Swapchain_Create", TLPArg(image.get(), "Image"));
+                TraceLoggingWriteTagged(local,
+                                        "Swapchain_Create",
+                                        TLPArg(image.get(), "Image"),
+                                        TLArg(!textureOnCompositionDevice, "BounceBuffered"));
 
                 m_images.push_back(std::move(image));
                 index++;
             }
 
-            // A fence to be used to synchronize between the application/runtime and the composition device.
-            m_fenceOnCompositionDevice = m_compositionDevice->createFence();
-            m_fenceOnApplicationDevice = m_applicationDevice->openFence(m_fenceOnCompositionDevice->getFenceHandle());
+            m_acquiredImages.resize(imagesCount);
+
+            m_stats.bounceBufferedImages =
+                (uint32_t)std::count(m_isBounceBuffered.cbegin(), m_isBounceBuffered.cend(), true);
+            m_stats.sharedImages = (uint32_t)m_images.size() - m_stats.bounceBufferedImages;
+            m_bytesPerCopy = (uint64_t)m_infoOnCompositionDevice.width * m_infoOnCompositionDevice.height *
+                             m_infoOnCompositionDevice.arraySize *
+                             getBytesPerPixel(m_compositionDevice->translateToGenericFormat(
+                                 m_infoOnCompositionDevice.format));
+            if (m_stats.bounceBufferedImages) {
+                Log(fmt::format("Swapchain {}x{}: {} of {} images use a bounce buffer ({}), {} bytes per copy\n",
+                                m_infoOnCompositionDevice.width,
+                                m_infoOnCompositionDevice.height,
+                                m_stats.bounceBufferedImages,
+                                m_images.size(),
+                                bounceReason,
+                                m_bytesPerCopy));
+            }
 
             TraceLoggingWriteStop(local, "Swapchain_Create", TLPArg(this, "Swapchain"));
         }
@@ -217,11 +270,12 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_Destroy", TLPArg(this, "Swapchain"));
 
-            if (m_fenceOnApplicationDevice) {
-                m_fenceOnApplicationDevice->waitOnCpu(m_fenceValue);
-            }
-            if (m_fenceOnCompositionDevice) {
-                m_fenceOnCompositionDevice->waitOnCpu(m_fenceValue);
+            m_timeline->waitOnCpu();
+            if (m_stats.bytesCopied) {
+                Log(fmt::format("Swapchain {}x{}: {} bytes copied through the bounce buffer\n",
+                                m_infoOnCompositionDevice.width,
+                                m_infoOnCompositionDevice.height,
+                                m_stats.bytesCopied));
             }
             if (xrDestroySwapchain) {
                 xrDestroySwapchain(m_swapchain);
@@ -234,23 +288,21 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_AcquireImage", TLPArg(this, "Swapchain"));
 
-            std::unique_lock lock(m_mutex);
-
             uint32_t index;
             CHECK_XRCMD(xrAcquireSwapchainImage(m_swapchain, nullptr, &index));
+            m_stats.bytesCopiedLastFrame = 0;
             if (wait) {
                 XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
                 waitInfo.timeout = XR_INFINITE_DURATION;
                 CHECK_XRCMD(xrWaitSwapchainImage(m_swapchain, &waitInfo));
             }
 
-            // Serialize the operations on the application device that might have occurred when acquiring the swapchain
-            // image.
-            m_fenceValue++;
-            m_fenceOnApplicationDevice->signal(m_fenceValue);
-            m_fenceOnCompositionDevice->waitOnDevice(m_fenceValue);
+            // Operations on the application device might have occurred when acquiring the swapchain image. They are
+            // serialized before the image is accessed from the composition device.
+            m_timeline->markApplicationWork();
 
-            m_acquiredImages.push_back(index);
+            // Cannot overflow: the runtime does not hand out more images than the swapchain has.
+            m_acquiredImages.push(index);
 
             ISwapchainImage* const image = m_images[index].get();
 
@@ -277,48 +329,48 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_ReleaseImage", TLPArg(this, "Swapchain"));
 
-            std::unique_lock lock(m_mutex);
-
             // We defer release of the OpenXR swapchain to ensure that we will have an opportunity to peek and/or poke
             // its content. If the same swapchain is released multiple times, then only defer the most recent call.
-            if (!(m_accessForRead || m_accessForWrite) || m_lastReleasedImage.has_value()) {
+            if (!(m_accessForRead || m_accessForWrite) || m_lastReleasedImage.load() != NoImage) {
                 CHECK_XRCMD(xrReleaseSwapchainImage(m_swapchain, nullptr));
-            } else if (m_acquiredImages.empty()) {
-                throw std::runtime_error("No image was acquired");
             }
 
-            m_lastReleasedImage = m_acquiredImages.front();
-            m_acquiredImages.pop_front();
+            const std::optional<uint32_t> index = m_acquiredImages.pop();
+            if (!index.has_value()) {
+                throw std::runtime_error("No image was acquired");
+            }
+            m_lastReleasedImage.store(index.value());
 
-            TraceLoggingWriteStop(local, "Swapchain_ReleaseImage", TLArg(m_lastReleasedImage.value(), "ReleasedIndex"));
+            TraceLoggingWriteStop(local, "Swapchain_ReleaseImage", TLArg(index.value(), "ReleasedIndex"));
         }
 
         ISwapchainImage* getLastReleasedImage() const override {
             TraceLocalActivity(local);
+            const uint32_t lastReleasedImage = m_lastReleasedImage.load();
             TraceLoggingWriteStart(local,
                                    "Swapchain_GetLastReleasedImage",
                                    TLPArg(this, "Swapchain"),
-                                   TLArg(m_lastReleasedImage.value_or(-1), "Index"));
+                                   TLArg((int)lastReleasedImage, "Index"));
 
             if (!m_accessForRead) {
                 throw std::runtime_error("Not a readable swapchain");
             }
 
             ISwapchainImage* image = nullptr;
-            if (m_lastReleasedImage.has_value()) {
-                if (m_bounceBufferOnApplicationDevice) {
+            if (lastReleasedImage != NoImage) {
+                if (m_isBounceBuffered[lastReleasedImage]) {
                     // The swapchain image wasn't shareable and we must perform a copy to a shareable texture accessible
                     // on the composition device.
-                    m_applicationDevice->copyTexture(m_images[m_lastReleasedImage.value()]->getApplicationTexture(),
+                    m_applicationDevice->copyTexture(m_images[lastReleasedImage]->getApplicationTexture(),
                                                      m_bounceBufferOnApplicationDevice.get());
+                    countCopy();
                 }
 
-                // Serialize the operations on the application device before accessing from the composition device.
-                m_fenceValue++;
-                m_fenceOnApplicationDevice->signal(m_fenceValue);
-                m_fenceOnCompositionDevice->waitOnDevice(m_fenceValue);
+                // The operations on the application device are serialized when the image is accessed from the
+                // composition device.
+                m_timeline->markApplicationWork();
 
-                image = m_images[m_lastReleasedImage.value()].get();
+                image = m_images[lastReleasedImage].get();
             }
 
             TraceLoggingWriteStop(local, "Swapchain_GetLastReleasedImage", TLPArg(image, "Image"));
@@ -328,31 +380,31 @@ namespace {
 
         void commitLastReleasedImage() override {
             TraceLocalActivity(local);
+            const uint32_t lastReleasedImage = m_lastReleasedImage.load();
             TraceLoggingWriteStart(local,
                                    "Swapchain_CommitLastReleasedImage",
                                    TLPArg(this, "Swapchain"),
-                                   TLArg(m_lastReleasedImage.value_or(-1), "Index"));
+                                   TLArg((int)lastReleasedImage, "Index"));
 
             if (!m_accessForWrite) {
                 throw std::runtime_error("Not a writable swapchain");
             }
 
-            if (m_lastReleasedImage.has_value()) {
+            if (lastReleasedImage != NoImage) {
                 // Serialize the operations on the composition device before copying to the application device or
                 // releasing the swapchain image.
-                m_fenceValue++;
-                m_fenceOnCompositionDevice->signal(m_fenceValue);
-                m_fenceOnApplicationDevice->waitOnDevice(m_fenceValue);
+                m_timeline->waitForComposition();
 
-                if (m_bounceBufferOnApplicationDevice) {
+                if (m_isBounceBuffered[lastReleasedImage]) {
                     // The swapchain image wasn't shareable and we must perform a copy from a shareable texture written
                     // on the composition device.
                     m_applicationDevice->copyTexture(m_bounceBufferOnApplicationDevice.get(),
-                                                     m_images[m_lastReleasedImage.value()]->getApplicationTexture());
+                                                     m_images[lastReleasedImage]->getApplicationTexture());
+                    countCopy();
                 }
 
                 CHECK_XRCMD(xrReleaseSwapchainImage(m_swapchain, nullptr));
-                m_lastReleasedImage = {};
+                m_lastReleasedImage.store(NoImage);
             }
 
             TraceLoggingWriteStop(local, "Swapchain_CommitLastReleasedImage");
@@ -374,6 +426,10 @@ namespace {
             return (uint32_t)m_images.size();
         }
 
+        SwapchainStats getStats() const override {
+            return m_stats;
+        }
+
         XrSwapchain getSwapchainHandle() const override {
             return m_swapchain;
         }
@@ -388,6 +444,29 @@ namespace {
             return subImage;
         }
 
+        // Probe the shareability of an image by actually opening it on the composition device.
+        std::shared_ptr<IGraphicsTexture> tryOpenOnCompositionDevice(IGraphicsTexture* textureOnApplicationDevice,
+                                                                     std::string& failureReason) {
+            try {
+                std::shared_ptr<IGraphicsTexture> texture = m_compositionDevice->openTexture(
+                    textureOnApplicationDevice->getTextureHandle(), m_infoOnCompositionDevice);
+                const XrSwapchainCreateInfo& info = texture->getInfo();
+                if (info.width == m_infoOnCompositionDevice.width && info.height == m_infoOnCompositionDevice.height &&
+                    info.arraySize == m_infoOnCompositionDevice.arraySize) {
+                    return texture;
+                }
+                failureReason = "opened texture does not match the swapchain";
+            } catch (std::exception& exc) {
+                failureReason = exc.what();
+            }
+            return {};
+        }
+
+        void countCopy() const {
+            m_stats.bytesCopied += m_bytesPerCopy;
+            m_stats.bytesCopiedLastFrame += m_bytesPerCopy;
+        }
+
         const XrSwapchain m_swapchain;
         const int64_t m_formatOnApplicationDevice;
         IGraphicsDevice* const m_compositionDevice;
@@ -406,24 +485,29 @@ namespace {
         std::vector<std::unique_ptr<ISwapchainImage>> m_images;
         std::shared_ptr<IGraphicsTexture> m_bounceBufferOnApplicationDevice;
         std::shared_ptr<IGraphicsTexture> m_bounceBufferOnCompositionDevice;
-        std::shared_ptr<IGraphicsFence> m_fenceOnApplicationDevice;
-        std::shared_ptr<IGraphicsFence> m_fenceOnCompositionDevice;
-        mutable uint64_t m_fenceValue{0};
+        std::vector<bool> m_isBounceBuffered;
+        uint64_t m_bytesPerCopy{0};
+        mutable SwapchainStats m_stats{};
+        const std::shared_ptr<FenceTimeline> m_timeline;
 
-        std::mutex m_mutex;
-        std::deque<uint32_t> m_acquiredImages;
-        std::optional<uint32_t> m_lastReleasedImage{};
+        IndexRing<uint32_t> m_acquiredImages;
+        std::atomic<uint32_t> m_lastReleasedImage{NoImage};
     };
 
     // A non-submittable swapchain must be accessible on both the application & composition device, however because it
     // does not need to be submitted, we can create the textures ourselves to ensure shareability and avoid extra
     // copies.
+    // The images are recycled through a free list: an image returns to the list once a more recent image was released,
+    // with a fence value covering the operations that used it. Acquiring waits for that value instead of requiring the
+    // caller to stay in lockstep with the GPU.
     struct NonSubmittableSwapchain : ISwapchain {
         NonSubmittableSwapchain(const XrSwapchainCreateInfo& infoOnApplicationDevice,
                                 IGraphicsDevice* applicationDevice,
                                 IGraphicsDevice* compositionDevice,
-                                SwapchainMode mode)
-            : m_infoOnCompositionDevice(infoOnApplicationDevice),
+                                std::shared_ptr<FenceTimeline> timeline,
+                                SwapchainMode mode,
+                                uint32_t imageCount)
+            : m_infoOnCompositionDevice(infoOnApplicationDevice), m_timeline(timeline),
               m_formatOnApplicationDevice(infoOnApplicationDevice.format),
               m_accessForRead((mode & SwapchainMode::Read) == SwapchainMode::Read),
               m_accessForWrite((mode & SwapchainMode::Write) == SwapchainMode::Write) {
@@ -434,28 +518,38 @@ namespace {
             m_infoOnCompositionDevice.format = compositionDevice->translateFromGenericFormat(
                 applicationDevice->translateToGenericFormat(infoOnApplicationDevice.format));
 
-            // We only need 2 textures since OpenXR only allows for 1 frame in-flight and we won't submit textures to a
-            // compositor that might need >2 images of history.
+            // 2 textures are enough since OpenXR only allows for 1 frame in-flight and we won't submit textures to a
+            // compositor that might need >2 images of history. More textures allow for deeper pipelining.
             // Make the textures available on the composition device.
-            for (uint32_t i = 0; i < 2; i++) {
+            imageCount = std::max(imageCount, 2u);
+            for (uint32_t i = 0; i < imageCount; i++) {
                 const std::shared_ptr<IGraphicsTexture> textureOnCompositionDevice =
                     compositionDevice->createTexture(m_infoOnCompositionDevice, true /* shareable */);
                 const std::shared_ptr<IGraphicsTexture> textureOnApplicationDevice = applicationDevice->openTexture(
                     textureOnCompositionDevice->getTextureHandle(), infoOnApplicationDevice);
-                std::unique_ptr<SwapchainImage> image =
-                    std::make_unique<SwapchainImage>(textureOnApplicationDevice, textureOnCompositionDevice, i);
+                std::unique_ptr<SwapchainImage> image = std::make_unique<SwapchainImage>(
+                    textureOnApplicationDevice, textureOnCompositionDevice, i, m_timeline.get());
 
                 TraceLoggingWriteTagged(local, "Swapchain_Create", TLPArg(image.get(), "Image"));
 
                 m_images.push_back(std::move(image));
             }
 
+            m_freeImages.resize(imageCount);
+            m_acquiredImages.resize(imageCount);
+            for (uint32_t i = 0; i < imageCount; i++) {
+                m_freeImages.push({i, 0});
+            }
+
             TraceLoggingWriteStop(local, "Swapchain_Create", TLPArg(this, "Swapchain"));
         }
 
         ~NonSubmittableSwapchain() override {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_Destroy", TLPArg(this, "Swapchain"));
+
+            m_timeline->waitOnCpu();
+
             TraceLoggingWriteStop(local, "Swapchain_Destroy");
         }
 
@@ -463,15 +557,19 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_AcquireImage", TLPArg(this, "Swapchain"));
 
-            std::unique_lock lock(m_mutex);
-
-            if (m_acquiredImages.size() == m_images.size()) {
-                throw std::runtime_error("No image available to acquire");
+            // All the images are held by the caller: nothing will become available until one is released.
+            const std::optional<ImageSlot> slot = m_freeImages.pop();
+            if (!slot.has_value()) {
+                TraceLoggingWriteStop(local, "Swapchain_AcquireImage", TLArg(true, "WouldBlock"));
+                return nullptr;
             }
 
-            const uint32_t index = m_nextImage++;
-            m_acquiredImages.push_back(index);
+            m_acquiredImages.push(slot.value());
+            if (wait) {
+                m_timeline->waitOnCpu(slot->fenceValue);
+            }
 
+            const uint32_t index = slot->index;
             ISwapchainImage* const image = m_images[index].get();
 
             TraceLoggingWriteStop(
@@ -484,12 +582,13 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_WaitImage", TLPArg(this, "Swapchain"));
 
-            std::unique_lock lock(m_mutex);
-
-            if (m_acquiredImages.empty()) {
+            const ImageSlot* const slot = m_acquiredImages.front();
+            if (!slot) {
                 throw std::runtime_error("No image was acquired");
             }
 
+            m_timeline->waitOnCpu(slot->fenceValue);
+
             TraceLoggingWriteStop(local, "Swapchain_WaitImage");
         }
 
@@ -497,30 +596,36 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "Swapchain_ReleaseImage", TLPArg(this, "Swapchain"));
 
-            std::unique_lock lock(m_mutex);
-
-            if (m_acquiredImages.empty()) {
+            const std::optional<ImageSlot> slot = m_acquiredImages.pop();
+            if (!slot.has_value()) {
                 throw std::runtime_error("No image was acquired");
             }
 
-            m_lastReleasedImage = m_acquiredImages.front();
-            m_acquiredImages.pop_front();
+            // The application device might have written the image since it was acquired.
+            m_timeline->markApplicationWork();
+
+            // The previously released image is superseded and can be recycled once the operations using it complete.
+            const uint32_t previousImage = m_lastReleasedImage.exchange(slot->index);
+            if (previousImage != NoImage) {
+                m_freeImages.push({previousImage, m_timeline->fenceAll()});
+            }
 
-            TraceLoggingWriteStop(local, "Swapchain_ReleaseImage", TLArg(m_lastReleasedImage, "ReleasedIndex"));
+            TraceLoggingWriteStop(local, "Swapchain_ReleaseImage", TLArg(slot->index, "ReleasedIndex"));
         }
 
         ISwapchainImage* getLastReleasedImage() const override {
             TraceLocalActivity(local);
+            const uint32_t lastReleasedImage = m_lastReleasedImage.load();
             TraceLoggingWriteStart(local,
                                    "Swapchain_GetLastReleasedImage",
                                    TLPArg(this, "Swapchain"),
-                                   TLArg(m_lastReleasedImage, "Index"));
+                                   TLArg((int)lastReleasedImage, "Index"));
 
             if (!m_accessForRead) {
                 throw std::runtime_error("Not a readable swapchain");
             }
 
-            ISwapchainImage* const image = m_images[m_lastReleasedImage].get();
+            ISwapchainImage* const image = lastReleasedImage != NoImage ? m_images[lastReleasedImage].get() : nullptr;
 
             TraceLoggingWriteStop(local, "Swapchain_GetLastReleasedImage", TLPArg(image, "Image"));
 
@@ -532,7 +637,7 @@ namespace {
             TraceLoggingWriteStart(local,
                                    "Swapchain_CommitLastReleasedImage",
                                    TLPArg(this, "Swapchain"),
-                                   TLArg(m_lastReleasedImage, "Index"));
+                                   TLArg((int)m_lastReleasedImage.load(), "Index"));
 
             if (!m_accessForWrite) {
                 throw std::runtime_error("Not a writable swapchain");
@@ -557,6 +662,12 @@ namespace {
             return (uint32_t)m_images.size();
         }
 
+        SwapchainStats getStats() const override {
+            SwapchainStats stats{};
+            stats.sharedImages = (uint32_t)m_images.size();
+            return stats;
+        }
+
         XrSwapchain getSwapchainHandle() const override {
             throw std::runtime_error("Not a submittable swapchain");
         }
@@ -570,13 +681,19 @@ namespace {
         const bool m_accessForWrite;
 
         XrSwapchainCreateInfo m_infoOnCompositionDevice;
+        const std::shared_ptr<FenceTimeline> m_timeline;
 
         std::vector<std::unique_ptr<ISwapchainImage>> m_images;
 
-        std::mutex m_mutex;
-        uint32_t m_nextImage{0};
-        std::deque<uint32_t> m_acquiredImages;
-        uint32_t m_lastReleasedImage{};
+        // An image, and the fence value to wait for before it can be used again (0 if it was never used).
+        struct ImageSlot {
+            uint32_t index;
+            uint64_t fenceValue;
+        };
+
+        IndexRing<ImageSlot> m_freeImages;
+        IndexRing<ImageSlot> m_acquiredImages;
+        std::atomic<uint32_t> m_lastReleasedImage{NoImage};
     };
 
     struct CompositionFramework : ICompositionFramework {
@@ -650,25 +767,18 @@ namespace {
                 throw std::runtime_error("Composition graphics API is not supported");
             }
 
-            m_fenceOnCompositionDevice = m_compositionDevice->createFence();
-            m_fenceOnApplicationDevice = m_applicationDevice->openFence(m_fenceOnCompositionDevice->getFenceHandle());
+            // One fence per direction, each created on the device that signals it.
+            std::shared_ptr<IGraphicsFence> applicationFence = m_applicationDevice->createFence();
+            std::shared_ptr<IGraphicsFence> compositionFence = m_compositionDevice->createFence();
+            m_timeline = std::make_shared<FenceTimeline>(
+                applicationFence,
+                m_compositionDevice->openFence(applicationFence->getFenceHandle()),
+                compositionFence,
+                m_applicationDevice->openFence(compositionFence->getFenceHandle()));
 
-            // Check for quirks.
-            PFN_xrGetInstanceProperties xrGetInstanceProperties;
-            CHECK_XRCMD(xrGetInstanceProcAddr(m_instance,
-                                              "xrGetInstanceProperties",
-                                              reinterpret_cast<PFN_xrVoidFunction*>(&xrGetInstanceProperties)));
-            XrInstanceProperties instanceProperties{XR_TYPE_INSTANCE_PROPERTIES};
-            CHECK_XRCMD(xrGetInstanceProperties(instance, &instanceProperties));
-            const std::string_view runtimeName(instanceProperties.runtimeName);
-#ifdef XR_USE_GRAPHICS_API_D3D12
-            if (runtimeName.find("Windows Mixed Reality") == std::string::npos &&
-                m_applicationDevice->getApi() == Api::D3D12) {
-                // Quirk: only WMR seems to implement a full D3D12 compositor. Other runtimes seem to use D3D11 and
-                // despite of D3D12 textures having the shareable flag, they are not shareable with D3D11.
-                m_overrideShareable = false;
-            }
-#endif
+            // Note: some runtimes flag their D3D12 swapchain images as shareable even though they cannot be opened
+            // with D3D11. Rather than assuming so based on the runtime name, each swapchain probes its images upon
+            // creation and only falls back to a bounce buffer for the ones that fail.
 
             // Get the preferred formats for swapchains.
             PFN_xrEnumerateSwapchainFormats xrEnumerateSwapchainFormats;
@@ -708,8 +818,8 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "CompositionFramework_Destroy", TLXArg(m_session, "Session"));
 
-            if (m_fenceOnCompositionDevice) {
-                m_fenceOnCompositionDevice->waitOnCpu(m_fenceValue);
+            if (m_timeline) {
+                m_timeline->waitOnCpu();
             }
 
             TraceLoggingWriteStop(local, "CompositionFramework_Destroy");
@@ -736,7 +846,8 @@ namespace {
         }
 
         std::shared_ptr<ISwapchain> createSwapchain(const XrSwapchainCreateInfo& infoOnApplicationDevice,
-                                                    SwapchainMode mode) override {
+                                                    SwapchainMode mode,
+                                                    uint32_t imageCount) override {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "CompositionFramework_CreateSwapchain",
@@ -750,7 +861,8 @@ namespace {
                                    TLArg(infoOnApplicationDevice.mipCount, "MipCount"),
                                    TLArg(infoOnApplicationDevice.sampleCount, "SampleCount"),
                                    TLArg(infoOnApplicationDevice.usageFlags, "UsageFlags"),
-                                   TLArg((int)mode, "Mode"));
+                                   TLArg((int)mode, "Mode"),
+                                   TLArg(imageCount, "ImageCount"));
 
             std::shared_ptr<ISwapchain> result;
             if ((mode & SwapchainMode::Submit) == SwapchainMode::Submit) {
@@ -764,11 +876,15 @@ namespace {
                                                                 infoOnApplicationDevice,
                                                                 m_applicationDevice.get(),
                                                                 m_compositionDevice.get(),
-                                                                mode,
-                                                                m_overrideShareable);
+                                                                m_timeline,
+                                                                mode);
             } else {
-                result = std::make_shared<NonSubmittableSwapchain>(
-                    infoOnApplicationDevice, m_applicationDevice.get(), m_compositionDevice.get(), mode);
+                result = std::make_shared<NonSubmittableSwapchain>(infoOnApplicationDevice,
+                                                                   m_applicationDevice.get(),
+                                                                   m_compositionDevice.get(),
+                                                                   m_timeline,
+                                                                   mode,
+                                                                   imageCount);
             }
 
             TraceLoggingWriteStop(local, "CompositionFramework_CreateSwapchain", TLPArg(result.get(), "Swapchain"));
@@ -780,11 +896,11 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local, "CompositionFramework_SerializePreComposition", TLXArg(m_session, "Session"));
 
-            std::unique_lock lock(m_fenceMutex);
-
-            m_fenceValue++;
-            m_fenceOnApplicationDevice->signal(m_fenceValue);
-            m_fenceOnCompositionDevice->waitOnDevice(m_fenceValue);
+            // The application rendered the frame. Serialize its operations once for all the swapchains, in case the
+            // composition device was obtained ahead of time.
+            telemetry::increment(telemetry::Event::CompositionFrame);
+            m_timeline->markApplicationWork();
+            m_timeline->waitForApplication();
 
             TraceLoggingWriteStop(local, "CompositionFramework_SerializePreComposition");
         }
@@ -794,16 +910,16 @@ namespace {
             TraceLoggingWriteStart(
                 local, "CompositionFramework_SerializePostComposition", TLXArg(m_session, "Session"));
 
-            std::unique_lock lock(m_fenceMutex);
-
-            m_fenceValue++;
-            m_fenceOnCompositionDevice->signal(m_fenceValue);
-            m_fenceOnApplicationDevice->waitOnDevice(m_fenceValue);
+            // Elided when nothing was done on the composition device during this frame.
+            m_timeline->waitForComposition();
 
             TraceLoggingWriteStop(local, "CompositionFramework_SerializePostComposition");
         }
 
         IGraphicsDevice* getCompositionDevice() const override {
+            // The caller is about to submit work to the composition device.
+            m_timeline->waitForApplication();
+            m_timeline->markCompositionWork();
             return m_compositionDevice.get();
         }
 
@@ -834,14 +950,7 @@ namespace {
         DXGI_FORMAT m_preferredSRGBColorFormat{DXGI_FORMAT_UNKNOWN};
         DXGI_FORMAT m_preferredDepthFormat{DXGI_FORMAT_UNKNOWN};
 
-        std::mutex m_fenceMutex;
-        std::shared_ptr<IGraphicsFence> m_fenceOnApplicationDevice;
-        std::shared_ptr<IGraphicsFence> m_fenceOnCompositionDevice;
-        uint64_t m_fenceValue{0};
-
-#ifdef XR_USE_GRAPHICS_API_D3D12
-        std::optional<bool> m_overrideShareable;
-#endif
+        std::shared_ptr<FenceTimeline> m_timeline;
 
         PFN_xrCreateSwapchain xrCreateSwapchain{nullptr};
     };
@@ -0,0 +1,107 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "constants.h"
+
+#include "log.h"
+
+namespace openxr_api_layer::utils::constants {
+
+    using namespace openxr_api_layer::log;
+
+    ID3D11Buffer* ConstantBufferCache::find(const Key& key, const void* params, size_t paramsSize) const {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end() || it->second.params.size() != paramsSize ||
+            memcmp(it->second.params.data(), params, paramsSize)) {
+            return nullptr;
+        }
+        return it->second.buffer.Get();
+    }
+
+    ID3D11Buffer* ConstantBufferCache::put(ID3D11Device* device,
+                                           ID3D11DeviceContext* context,
+                                           const Key& key,
+                                           const void* params,
+                                           size_t paramsSize,
+                                           const void* contents,
+                                           size_t contentsSize) {
+        Entry& entry = m_entries[key];
+
+        // Constant buffers are sized in multiples of 16 bytes, and can only be written as a whole.
+        const UINT byteWidth = (UINT)((contentsSize + 15) & ~size_t(15));
+        std::vector<uint8_t> padded(byteWidth);
+        memcpy(padded.data(), contents, contentsSize);
+
+        if (!entry.buffer || entry.byteWidth != byteWidth) {
+            // Default usage: the contents rarely change, so there is no point in having the driver rename a dynamic
+            // buffer on every Map().
+            D3D11_BUFFER_DESC desc{};
+            desc.ByteWidth = byteWidth;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+            D3D11_SUBRESOURCE_DATA data{};
+            data.pSysMem = padded.data();
+            if (FAILED(device->CreateBuffer(&desc, &data, entry.buffer.ReleaseAndGetAddressOf()))) {
+                ErrorLog(fmt::format("Failed to create constant buffer of {} bytes\n", byteWidth));
+                m_entries.erase(key);
+                return nullptr;
+            }
+            entry.byteWidth = byteWidth;
+        } else {
+            // With the 11.1 interface, the driver does not need to wait for in-flight dispatches reading the previous
+            // contents.
+            Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1;
+            if (SUCCEEDED(context->QueryInterface(context1.ReleaseAndGetAddressOf()))) {
+                context1->UpdateSubresource1(entry.buffer.Get(), 0, nullptr, padded.data(), 0, 0, D3D11_COPY_DISCARD);
+            } else {
+                context->UpdateSubresource(entry.buffer.Get(), 0, nullptr, padded.data(), 0, 0);
+            }
+        }
+        entry.params.assign((const uint8_t*)params, (const uint8_t*)params + paramsSize);
+        return entry.buffer.Get();
+    }
+
+    ID3D11Buffer* ConstantBufferCache::update(ID3D11Device* device,
+                                              ID3D11DeviceContext* context,
+                                              const Key& key,
+                                              const void* contents,
+                                              size_t contentsSize) {
+        if (ID3D11Buffer* buffer = find(key, contents, contentsSize)) {
+            return buffer;
+        }
+        return put(device, context, key, contents, contentsSize, contents, contentsSize);
+    }
+
+    void ConstantBufferCache::erase(const Key& key) {
+        m_entries.erase(key);
+    }
+
+    void ConstantBufferCache::clear() {
+        m_entries.clear();
+    }
+
+} // namespace openxr_api_layer::utils::constants
@@ -0,0 +1,88 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::constants {
+
+    // Identifies a constant buffer: its owner (eg: a swapchain), an index within the owner (eg: an array slice) and a
+    // slot (eg: a pass).
+    struct Key {
+        uint64_t owner{0};
+        uint32_t index{0};
+        uint32_t slot{0};
+
+        bool operator==(const Key& other) const {
+            return owner == other.owner && index == other.index && slot == other.slot;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            // As boost::hash_combine(). Only the bucket distribution depends on it, equality is checked on all fields.
+            size_t hash = std::hash<uint64_t>()(key.owner);
+            hash ^= std::hash<uint64_t>()((uint64_t(key.index) << 32) | key.slot) + 0x9e3779b9 + (hash << 6) +
+                    (hash >> 2);
+            return hash;
+        }
+    };
+
+    // Constant buffers identified by a key, each remembering what it was last built from. Uploads of unchanged contents
+    // are skipped, so the steady state does no buffer writes at all.
+    class ConstantBufferCache {
+      public:
+        // Return the buffer of key if it was last built from params, or null if it must be (re)built with put().
+        ID3D11Buffer* find(const Key& key, const void* params, size_t paramsSize) const;
+
+        // Store the contents derived from params in the buffer of key, creating it if needed. Null on failure.
+        ID3D11Buffer* put(ID3D11Device* device,
+                          ID3D11DeviceContext* context,
+                          const Key& key,
+                          const void* params,
+                          size_t paramsSize,
+                          const void* contents,
+                          size_t contentsSize);
+
+        // Shorthand for buffers whose contents are their own params.
+        ID3D11Buffer* update(ID3D11Device* device,
+                             ID3D11DeviceContext* context,
+                             const Key& key,
+                             const void* contents,
+                             size_t contentsSize);
+
+        void erase(const Key& key);
+        void clear();
+
+      private:
+        struct Entry {
+            Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+            UINT byteWidth{0};
+            std::vector<uint8_t> params;
+        };
+
+        std::unordered_map<Key, Entry, KeyHash> m_entries;
+    };
+
+} // namespace openxr_api_layer::utils::constants
@@ -0,0 +1,351 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+
+#include "d3d12passes.h"
+
+#include "log.h"
+
+namespace openxr_api_layer::utils::d3d12passes {
+
+    using namespace openxr_api_layer::log;
+
+    Backend::Backend(ID3D12Device* device, ID3D12CommandQueue* queue) : m_device(device), m_queue(queue) {
+        D3D12_DESCRIPTOR_RANGE ranges[2]{};
+        ranges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        ranges[0].NumDescriptors = 1;
+        ranges[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+        ranges[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        ranges[1].NumDescriptors = 1;
+        ranges[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+        D3D12_ROOT_PARAMETER parameters[3]{};
+        parameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        parameters[0].Constants.ShaderRegister = 0;
+        parameters[0].Constants.Num32BitValues = Constants0Count;
+        parameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+        parameters[1].Constants.ShaderRegister = 1;
+        parameters[1].Constants.Num32BitValues = Constants1Count;
+        parameters[2].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+        parameters[2].DescriptorTable.NumDescriptorRanges = (UINT)std::size(ranges);
+        parameters[2].DescriptorTable.pDescriptorRanges = ranges;
+        D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc{};
+        rootSignatureDesc.NumParameters = (UINT)std::size(parameters);
+        rootSignatureDesc.pParameters = parameters;
+        ComPtr<ID3DBlob> serialized, error;
+        CHECK_HRCMD(D3D12SerializeRootSignature(&rootSignatureDesc,
+                                                D3D_ROOT_SIGNATURE_VERSION_1,
+                                                serialized.ReleaseAndGetAddressOf(),
+                                                error.ReleaseAndGetAddressOf()));
+        CHECK_HRCMD(m_device->CreateRootSignature(0,
+                                                  serialized->GetBufferPointer(),
+                                                  serialized->GetBufferSize(),
+                                                  IID_PPV_ARGS(m_rootSignature.ReleaseAndGetAddressOf())));
+        m_rootSignature->SetName(L"CAS Root Signature");
+
+        D3D12_DESCRIPTOR_HEAP_DESC heapDesc{};
+        heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        heapDesc.NumDescriptors = FramesInFlight * DescriptorsPerFrame;
+        heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        CHECK_HRCMD(m_device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(m_descriptorHeap.ReleaseAndGetAddressOf())));
+        m_descriptorHeap->SetName(L"CAS Descriptor Heap");
+        m_descriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+        queryHeapDesc.Count = FramesInFlight * TimestampsPerFrame;
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        CHECK_HRCMD(m_device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(m_queryHeap.ReleaseAndGetAddressOf())));
+        m_queryHeap->SetName(L"CAS Timestamp Query Heap");
+
+        D3D12_HEAP_PROPERTIES readbackHeap{};
+        readbackHeap.Type = D3D12_HEAP_TYPE_READBACK;
+        readbackHeap.CreationNodeMask = readbackHeap.VisibleNodeMask = 1;
+        D3D12_RESOURCE_DESC readbackDesc{};
+        readbackDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        readbackDesc.Width = queryHeapDesc.Count * sizeof(uint64_t);
+        readbackDesc.Height = readbackDesc.DepthOrArraySize = readbackDesc.MipLevels = readbackDesc.SampleDesc.Count =
+            1;
+        readbackDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        CHECK_HRCMD(m_device->CreateCommittedResource(&readbackHeap,
+                                                      D3D12_HEAP_FLAG_NONE,
+                                                      &readbackDesc,
+                                                      D3D12_RESOURCE_STATE_COPY_DEST,
+                                                      nullptr,
+                                                      IID_PPV_ARGS(m_timestampReadback.ReleaseAndGetAddressOf())));
+        m_timestampReadback->SetName(L"CAS Timestamp Readback Buffer");
+
+        // The command lists must match the type of the queue they are submitted to.
+        const D3D12_COMMAND_LIST_TYPE type = m_queue->GetDesc().Type;
+        for (Frame& frame : m_frames) {
+            CHECK_HRCMD(
+                m_device->CreateCommandAllocator(type, IID_PPV_ARGS(frame.allocator.ReleaseAndGetAddressOf())));
+            frame.allocator->SetName(L"CAS Command Allocator");
+            CHECK_HRCMD(m_device->CreateCommandList(
+                0, type, frame.allocator.Get(), nullptr, IID_PPV_ARGS(frame.commandList.ReleaseAndGetAddressOf())));
+            frame.commandList->SetName(L"CAS Command List");
+            CHECK_HRCMD(frame.commandList->Close());
+        }
+        CHECK_HRCMD(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+        m_fence->SetName(L"CAS Fence");
+    }
+
+    Backend::~Backend() {
+        waitForFence(m_fenceValue);
+    }
+
+    ComPtr<ID3D12PipelineState> Backend::createPipeline(const void* bytecode, size_t size, const wchar_t* name) const {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc{};
+        desc.pRootSignature = m_rootSignature.Get();
+        desc.CS.pShaderBytecode = bytecode;
+        desc.CS.BytecodeLength = size;
+        ComPtr<ID3D12PipelineState> pipeline;
+        if (FAILED(m_device->CreateComputePipelineState(&desc, IID_PPV_ARGS(pipeline.ReleaseAndGetAddressOf())))) {
+            return nullptr;
+        }
+        pipeline->SetName(name);
+        return pipeline;
+    }
+
+    void Backend::beginFrame() {
+        if (m_recording) {
+            // The previous frame was interrupted by an exception. Submit what it recorded, the tracked states match it.
+            endFrame();
+        }
+        Frame& frame = m_frames[m_frameIndex];
+        waitForFence(frame.fenceValue);
+        if (frame.timestampCount) {
+            const size_t first = m_frameIndex * TimestampsPerFrame;
+            D3D12_RANGE range{first * sizeof(uint64_t), (first + frame.timestampCount) * sizeof(uint64_t)};
+            uint8_t* mapped = nullptr;
+            if (SUCCEEDED(m_timestampReadback->Map(0, &range, reinterpret_cast<void**>(&mapped)))) {
+                const uint64_t* timestamps = reinterpret_cast<const uint64_t*>(mapped + range.Begin);
+                m_lastTimestamps.assign(timestamps, timestamps + frame.timestampCount);
+                m_hasTimestamps = true;
+                const D3D12_RANGE written{0, 0};
+                m_timestampReadback->Unmap(0, &written);
+            }
+            frame.timestampCount = 0;
+        }
+        frame.references.clear();
+
+        CHECK_HRCMD(frame.allocator->Reset());
+        CHECK_HRCMD(frame.commandList->Reset(frame.allocator.Get(), nullptr));
+        ID3D12DescriptorHeap* const heaps[] = {m_descriptorHeap.Get()};
+        frame.commandList->SetDescriptorHeaps(1, heaps);
+        frame.commandList->SetComputeRootSignature(m_rootSignature.Get());
+        m_descriptorsUsed = 0;
+        m_recording = true;
+    }
+
+    void Backend::endFrame() {
+        Frame& frame = m_frames[m_frameIndex];
+        flushBarriers();
+        if (frame.timestampCount) {
+            const UINT first = m_frameIndex * TimestampsPerFrame;
+            frame.commandList->ResolveQueryData(m_queryHeap.Get(),
+                                                D3D12_QUERY_TYPE_TIMESTAMP,
+                                                first,
+                                                frame.timestampCount,
+                                                m_timestampReadback.Get(),
+                                                first * sizeof(uint64_t));
+        }
+        CHECK_HRCMD(frame.commandList->Close());
+        ID3D12CommandList* const lists[] = {frame.commandList.Get()};
+        m_queue->ExecuteCommandLists(1, lists);
+        CHECK_HRCMD(m_queue->Signal(m_fence.Get(), ++m_fenceValue));
+        frame.fenceValue = m_fenceValue;
+        m_frameIndex = (m_frameIndex + 1) % FramesInFlight;
+        m_recording = false;
+    }
+
+    void Backend::transition(TrackedResource& resource, D3D12_RESOURCE_STATES state) {
+        if (resource.state == state) {
+            return;
+        }
+        D3D12_RESOURCE_BARRIER barrier{};
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Transition.pResource = resource.resource.Get();
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        barrier.Transition.StateBefore = resource.state;
+        barrier.Transition.StateAfter = state;
+        m_pendingBarriers.push_back(barrier);
+        resource.state = state;
+    }
+
+    void Backend::copyRegion(TrackedResource& destination,
+                             UINT destinationSubresource,
+                             UINT x,
+                             UINT y,
+                             TrackedResource& source,
+                             UINT sourceSubresource,
+                             const D3D12_BOX& box) {
+        transition(destination, D3D12_RESOURCE_STATE_COPY_DEST);
+        transition(source, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        flushBarriers();
+        m_frames[m_frameIndex].references.insert(m_frames[m_frameIndex].references.end(),
+                                                 {destination.resource, source.resource});
+        D3D12_TEXTURE_COPY_LOCATION dst{};
+        dst.pResource = destination.resource.Get();
+        dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        dst.SubresourceIndex = destinationSubresource;
+        D3D12_TEXTURE_COPY_LOCATION src{};
+        src.pResource = source.resource.Get();
+        src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        src.SubresourceIndex = sourceSubresource;
+        m_frames[m_frameIndex].commandList->CopyTextureRegion(&dst, x, y, 0, &src, &box);
+    }
+
+    bool Backend::setPass(ID3D12PipelineState* pipeline,
+                          const void* constants0,
+                          uint32_t constants0Size,
+                          const void* constants1,
+                          uint32_t constants1Size,
+                          TrackedResource& input,
+                          DXGI_FORMAT srvFormat,
+                          TrackedResource& output,
+                          DXGI_FORMAT uavFormat) {
+        if (m_descriptorsUsed + 2 > DescriptorsPerFrame) {
+            return false;
+        }
+        transition(input, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        transition(output, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        flushBarriers();
+
+        // The views of the pass go to the next two descriptors of the frame's share of the heap.
+        const UINT first = m_frameIndex * DescriptorsPerFrame + m_descriptorsUsed;
+        m_descriptorsUsed += 2;
+        D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = m_descriptorHeap->GetCPUDescriptorHandleForHeapStart();
+        cpuHandle.ptr += SIZE_T(first) * m_descriptorSize;
+        D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = m_descriptorHeap->GetGPUDescriptorHandleForHeapStart();
+        gpuHandle.ptr += UINT64(first) * m_descriptorSize;
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+        srvDesc.Format = srvFormat;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture2D.MipLevels = 1;
+        m_device->CreateShaderResourceView(input.resource.Get(), &srvDesc, cpuHandle);
+        cpuHandle.ptr += m_descriptorSize;
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+        uavDesc.Format = uavFormat;
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        m_device->CreateUnorderedAccessView(output.resource.Get(), nullptr, &uavDesc, cpuHandle);
+
+        Frame& frame = m_frames[m_frameIndex];
+        frame.references.insert(frame.references.end(), {pipeline, input.resource, output.resource});
+        ID3D12GraphicsCommandList* commandList = frame.commandList.Get();
+        commandList->SetPipelineState(pipeline);
+        commandList->SetComputeRoot32BitConstants(0, constants0Size / sizeof(uint32_t), constants0, 0);
+        if (constants1) {
+            commandList->SetComputeRoot32BitConstants(1, constants1Size / sizeof(uint32_t), constants1, 0);
+        }
+        commandList->SetComputeRootDescriptorTable(2, gpuHandle);
+        return true;
+    }
+
+    void Backend::dispatch(UINT x, UINT y, UINT z) {
+        m_frames[m_frameIndex].commandList->Dispatch(x, y, z);
+    }
+
+    void Backend::writeTimestamp(uint32_t index) {
+        Frame& frame = m_frames[m_frameIndex];
+        frame.commandList->EndQuery(
+            m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, m_frameIndex * TimestampsPerFrame + index);
+        frame.timestampCount = std::max(frame.timestampCount, index + 1);
+    }
+
+    bool Backend::getTimestamps(uint64_t* timestamps, uint32_t count, uint64_t& frequency) {
+        if (!m_hasTimestamps || m_lastTimestamps.size() < count || FAILED(m_queue->GetTimestampFrequency(&frequency))) {
+            return false;
+        }
+        std::copy_n(m_lastTimestamps.begin(), count, timestamps);
+        m_hasTimestamps = false;
+        return true;
+    }
+
+    bool Backend::ensureTempTextures(
+        TempTextures& textures, UINT width, UINT height, DXGI_FORMAT format, DXGI_FORMAT resourceFormat) {
+        if (textures.input.resource && textures.width == width && textures.height == height &&
+            textures.format == format) {
+            return true;
+        }
+        // The frames in flight keep the old textures alive.
+        textures = {};
+
+        D3D12_HEAP_PROPERTIES heap{};
+        heap.Type = D3D12_HEAP_TYPE_DEFAULT;
+        heap.CreationNodeMask = heap.VisibleNodeMask = 1;
+        D3D12_RESOURCE_DESC desc{};
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        desc.Width = width;
+        desc.Height = height;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
+        desc.Format = resourceFormat;
+        desc.SampleDesc.Count = 1;
+        desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+        for (TrackedResource* texture : {&textures.input, &textures.output}) {
+            if (FAILED(m_device->CreateCommittedResource(&heap,
+                                                         D3D12_HEAP_FLAG_NONE,
+                                                         &desc,
+                                                         D3D12_RESOURCE_STATE_COMMON,
+                                                         nullptr,
+                                                         IID_PPV_ARGS(texture->resource.ReleaseAndGetAddressOf())))) {
+                ErrorLog("CAS: CreateCommittedResource failed for a temporary texture\n");
+                return false;
+            }
+            texture->resource->SetName(L"CAS Temporary Texture");
+            texture->state = D3D12_RESOURCE_STATE_COMMON;
+        }
+        textures.width = width;
+        textures.height = height;
+        textures.format = format;
+        return true;
+    }
+
+    void Backend::waitForFence(uint64_t value) {
+        if (m_fence->GetCompletedValue() >= value) {
+            return;
+        }
+        wil::unique_handle eventHandle;
+        *eventHandle.put() = CreateEventEx(nullptr, L"D3D Fence", 0, EVENT_ALL_ACCESS);
+        if (eventHandle && SUCCEEDED(m_fence->SetEventOnCompletion(value, eventHandle.get()))) {
+            WaitForSingleObject(eventHandle.get(), INFINITE);
+        }
+    }
+
+    void Backend::flushBarriers() {
+        if (!m_pendingBarriers.empty()) {
+            m_frames[m_frameIndex].commandList->ResourceBarrier((UINT)m_pendingBarriers.size(),
+                                                                m_pendingBarriers.data());
+            m_pendingBarriers.clear();
+        }
+    }
+
+} // namespace openxr_api_layer::utils::d3d12passes
+
+#endif
@@ -0,0 +1,159 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+
+namespace openxr_api_layer::utils::d3d12passes {
+
+    // The root signature shared by all passes: root constants for the cbuffers at b0 and b1 (see shaders/*.hlsl), then
+    // a descriptor table with the input SRV at t0 and the output UAV at u0. Sizes are in 32-bit values.
+    constexpr uint32_t Constants0Count = 12;
+    constexpr uint32_t Constants1Count = 8;
+
+    // A resource along with the state the backend's command lists last left it in.
+    struct TrackedResource {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        D3D12_RESOURCE_STATES state{D3D12_RESOURCE_STATE_COMMON};
+    };
+
+    // The intermediate textures of a swapchain slice, used as in the D3D11 path.
+    struct TempTextures {
+        TrackedResource input;
+        TrackedResource output;
+        UINT width{}, height{};
+        DXGI_FORMAT format{};
+    };
+
+    // Records the post-processing passes of a D3D12 session and submits them to a queue of the application's device.
+    // Each frame in flight has its own command allocator and its own share of a shader-visible descriptor heap, both
+    // reused once a fence shows that the GPU is done with the frame. Frames also hold a reference to the pipelines and
+    // resources they use until then, so that callers may release theirs at any time. Pipelines are created from DXBC
+    // bytecode against the shared root signature.
+    class Backend {
+      public:
+        static constexpr uint32_t FramesInFlight = 3;
+        static constexpr uint32_t DescriptorsPerFrame = 256;
+        static constexpr uint32_t TimestampsPerFrame = 8;
+
+        // Throws if the objects cannot be created.
+        Backend(ID3D12Device* device, ID3D12CommandQueue* queue);
+
+        // Waits for the frames in flight.
+        ~Backend();
+
+        ID3D12Device* getDevice() const {
+            return m_device.Get();
+        }
+
+        // Thread-safe. Null on failure.
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> createPipeline(const void* bytecode,
+                                                                   size_t size,
+                                                                   const wchar_t* name) const;
+
+        // Open the command list of the next frame, first waiting for the GPU to retire the frame that last used its
+        // allocator. A frame left open is submitted first.
+        void beginFrame();
+
+        // Close the command list and submit it, followed by a fence signal.
+        void endFrame();
+
+        bool isRecording() const {
+            return m_recording;
+        }
+
+        // Queue a transition of a whole resource. Barriers are batched until the next copy or dispatch.
+        void transition(TrackedResource& resource, D3D12_RESOURCE_STATES state);
+
+        // Copy a box of a subresource, after transitioning both resources for the copy.
+        void copyRegion(TrackedResource& destination,
+                        UINT destinationSubresource,
+                        UINT x,
+                        UINT y,
+                        TrackedResource& source,
+                        UINT sourceSubresource,
+                        const D3D12_BOX& box);
+
+        // Bind a pass reading input and writing output, after transitioning them. The constants are copied into the
+        // command list. Returns false when the frame has run out of descriptors.
+        bool setPass(ID3D12PipelineState* pipeline,
+                     const void* constants0,
+                     uint32_t constants0Size,
+                     const void* constants1,
+                     uint32_t constants1Size,
+                     TrackedResource& input,
+                     DXGI_FORMAT srvFormat,
+                     TrackedResource& output,
+                     DXGI_FORMAT uavFormat);
+
+        void dispatch(UINT x, UINT y, UINT z);
+
+        // Write a GPU timestamp at index (below TimestampsPerFrame) of the current frame.
+        void writeTimestamp(uint32_t index);
+
+        // Return the timestamps of the most recently retired frame that wrote some, only once. The count is the highest
+        // index written plus one.
+        bool getTimestamps(uint64_t* timestamps, uint32_t count, uint64_t& frequency);
+
+        // (Re)create a pair of single-slice textures with UAV access, unless they already match.
+        bool ensureTempTextures(
+            TempTextures& textures, UINT width, UINT height, DXGI_FORMAT format, DXGI_FORMAT resourceFormat);
+
+      private:
+        struct Frame {
+            Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+            Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
+            uint64_t fenceValue{0};
+            uint32_t timestampCount{0};
+            std::vector<Microsoft::WRL::ComPtr<ID3D12Pageable>> references;
+        };
+
+        void waitForFence(uint64_t value);
+        void flushBarriers();
+
+        Microsoft::WRL::ComPtr<ID3D12Device> m_device;
+        Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_queue;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> m_rootSignature;
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_descriptorHeap;
+        UINT m_descriptorSize{0};
+        Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_queryHeap;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_timestampReadback;
+        Microsoft::WRL::ComPtr<ID3D12Fence> m_fence;
+        uint64_t m_fenceValue{0};
+
+        Frame m_frames[FramesInFlight];
+        uint32_t m_frameIndex{0};
+        bool m_recording{false};
+        uint32_t m_descriptorsUsed{0};
+        std::vector<D3D12_RESOURCE_BARRIER> m_pendingBarriers;
+
+        std::vector<uint64_t> m_lastTimestamps;
+        bool m_hasTimestamps{false};
+    };
+
+} // namespace openxr_api_layer::utils::d3d12passes
+
+#endif
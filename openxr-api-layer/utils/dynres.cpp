@@ -0,0 +1,118 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "dynres.h"
+
+namespace openxr_api_layer::utils::dynres {
+
+    Controller::Controller(const ControllerSettings& settings) : m_settings(settings) {
+        reset(m_settings.maxScale);
+    }
+
+    void Controller::reset(float scale) {
+        restart(scale);
+        m_utilization = 0.0f;
+        m_hasUtilization = false;
+        m_followed = true;
+    }
+
+    float Controller::update(double frameTimeMs, double displayPeriodMs, float renderedScale) {
+        m_framesSinceChange++;
+        if (frameTimeMs <= 0.0 || displayPeriodMs <= 0.0) {
+            return m_scale;
+        }
+
+        const float sample = (float)(frameTimeMs / displayPeriodMs);
+        m_utilization =
+            m_hasUtilization ? m_utilization + m_settings.smoothing * (sample - m_utilization) : sample;
+        m_hasUtilization = true;
+
+        if (renderedScale > 0.0f) {
+            const float rendered = std::clamp(renderedScale, m_settings.minScale, m_settings.maxScale);
+            const bool matches = std::abs(rendered - m_scale) <= m_settings.step * 0.5f;
+            if (m_followed && !matches && m_framesSinceChange >= m_settings.followFrames) {
+                m_followed = false;
+                restart(rendered);
+            } else if (!m_followed && !matches) {
+                // The application changed its resolution: give it another chance from there.
+                m_followed = true;
+                restart(rendered);
+            }
+            if (!m_followed) {
+                return m_scale;
+            }
+        }
+
+        // Incremental PID: the output is a change of scale, which avoids integral windup when the scale saturates.
+        // The cost of a frame grows with the pixel count, ie: the square of the scale, hence the error is taken on the
+        // square root of the utilization.
+        const float error = std::sqrt(m_settings.targetUtilization) - std::sqrt(m_utilization);
+        const float delta = m_settings.kp * (error - m_error1) + m_settings.ki * error +
+                            m_settings.kd * (error - 2.0f * m_error1 + m_error2);
+        m_error2 = m_error1;
+        m_error1 = error;
+        m_continuousScale = std::clamp(m_continuousScale + delta, m_settings.minScale, m_settings.maxScale);
+
+        // Hysteresis: only leave the current step once the continuous scale is well past the midpoint to the next one.
+        const float hysteresis = m_settings.step * 0.75f;
+        const bool goDown = m_scale - m_continuousScale > hysteresis;
+        bool goUp = m_continuousScale - m_scale > hysteresis;
+        if (goUp) {
+            // When the target falls between two steps, the upper one is over the target: going up would only come back
+            // down after a while, and so on. Stay put unless the utilization predicted at the new scale is acceptable,
+            // and keep the continuous scale from drifting away meanwhile.
+            const float ratio = quantize(m_continuousScale) / m_scale;
+            if (m_utilization * ratio * ratio > m_settings.targetUtilization) {
+                goUp = false;
+                m_continuousScale = m_scale + hysteresis;
+            }
+        }
+        if ((goDown && m_framesSinceChange >= m_settings.holdFramesDown) ||
+            (goUp && m_framesSinceChange >= m_settings.holdFramesUp)) {
+            m_scale = quantize(m_continuousScale);
+            m_framesSinceChange = 0;
+        }
+
+        return m_scale;
+    }
+
+    void Controller::restart(float scale) {
+        m_scale = quantize(std::clamp(scale, m_settings.minScale, m_settings.maxScale));
+        m_continuousScale = m_scale;
+        m_error1 = m_error2 = 0.0f;
+        m_framesSinceChange = 0;
+    }
+
+    float Controller::quantize(float scale) const {
+        if (m_settings.step <= 0.0f) {
+            return scale;
+        }
+        const float quantized = std::round(scale / m_settings.step) * m_settings.step;
+        return std::clamp(quantized, m_settings.minScale, m_settings.maxScale);
+    }
+
+} // namespace openxr_api_layer::utils::dynres
@@ -0,0 +1,113 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::dynres {
+
+    struct ControllerSettings {
+        // Range of the render scale (per axis).
+        float minScale{0.5f};
+        float maxScale{1.0f};
+
+        // The render scale only takes multiples of this step, so that the output swapchains are not recreated for
+        // every small variation.
+        float step{0.05f};
+
+        // Fraction of the display period that a frame should take. The margin absorbs frame time spikes.
+        float targetUtilization{0.85f};
+
+        // Gains of the PID acting on the utilization error.
+        float kp{0.4f};
+        float ki{0.02f};
+        float kd{0.2f};
+
+        // Weight of the newest sample in the frame time average.
+        float smoothing{0.1f};
+
+        // Minimum number of frames between two scale changes. Lowering the scale reacts faster than raising it, so
+        // that dropped frames are short-lived and the scale does not oscillate around the limit.
+        uint32_t holdFramesDown{10};
+        uint32_t holdFramesUp{90};
+
+        // Number of frames the application is given to start rendering at a new scale, before it is considered not to
+        // follow the recommended resolution.
+        uint32_t followFrames{45};
+    };
+
+    // A closed-loop controller picking the render scale that keeps the frame time within the display period.
+    // The controller does not depend on any timing source, so recorded frame time traces can be replayed through it.
+    class Controller {
+      public:
+        explicit Controller(const ControllerSettings& settings = {});
+
+        // Restart from a given render scale, forgetting all history.
+        void reset(float scale);
+
+        // Feed the duration of one frame and the display period it should fit in, and the scale the frame was actually
+        // rendered at (0 if unknown). Returns the render scale to use for the following frames.
+        // An application that keeps rendering at another scale (eg: it never queries the recommended resolution again)
+        // does not follow the controller: the controller then holds the scale the application renders at, instead of
+        // drifting to the end of its range without any effect on the frame time. It resumes once the application
+        // changes its resolution.
+        float update(double frameTimeMs, double displayPeriodMs, float renderedScale = 0.0f);
+
+        // The quantized render scale.
+        float getScale() const {
+            return m_scale;
+        }
+
+        // The render scale before quantization and hysteresis.
+        float getContinuousScale() const {
+            return m_continuousScale;
+        }
+
+        // Whether the application renders at the scale requested by the controller.
+        bool isFollowed() const {
+            return m_followed;
+        }
+
+        // Smoothed ratio of the frame time to the display period.
+        float getUtilization() const {
+            return m_utilization;
+        }
+
+      private:
+        float quantize(float scale) const;
+        void restart(float scale);
+
+        const ControllerSettings m_settings;
+
+        float m_scale{1.0f};
+        float m_continuousScale{1.0f};
+        float m_utilization{0.0f};
+        bool m_hasUtilization{false};
+        float m_error1{0.0f};
+        float m_error2{0.0f};
+        uint32_t m_framesSinceChange{0};
+        bool m_followed{true};
+    };
+
+} // namespace openxr_api_layer::utils::dynres
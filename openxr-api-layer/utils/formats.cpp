@@ -0,0 +1,105 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "formats.h"
+
+namespace {
+
+    using namespace openxr_api_layer::utils::formats;
+
+    // clang-format off
+    const FormatInfo FormatTable[] = {
+        // format, resourceFormat, srvFormat, uavFormat, packedUavFormat, packedStoreMode, isSRGB
+        {DXGI_FORMAT_R8G8B8A8_UNORM,       DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UINT,    StoreMode::PackedUnorm8,  false},
+        {DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,  DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UINT,    StoreMode::PackedUnorm8,  true},
+        {DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_TYPELESS,    DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UNORM,     DXGI_FORMAT_R8G8B8A8_UINT,    StoreMode::PackedUnorm8,  false},
+        {DXGI_FORMAT_B8G8R8A8_UNORM,       DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         true},
+        {DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_TYPELESS,    DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_B8G8R8A8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_B8G8R8X8_UNORM,       DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,  DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         true},
+        {DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_TYPELESS,    DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_B8G8R8X8_UNORM,     DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_R10G10B10A2_UNORM,    DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UINT, StoreMode::PackedUnorm10, false},
+        {DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UNORM,  DXGI_FORMAT_R10G10B10A2_UINT, StoreMode::PackedUnorm10, false},
+        {DXGI_FORMAT_R11G11B10_FLOAT,      DXGI_FORMAT_R11G11B10_FLOAT,      DXGI_FORMAT_R11G11B10_FLOAT,    DXGI_FORMAT_R11G11B10_FLOAT,    DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+        {DXGI_FORMAT_R16G16B16A16_FLOAT,   DXGI_FORMAT_R16G16B16A16_FLOAT,   DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_UNKNOWN,          StoreMode::Typed,         false},
+    };
+    // clang-format on
+
+} // namespace
+
+namespace openxr_api_layer::utils::formats {
+
+    const FormatInfo* getFormatInfo(DXGI_FORMAT format) {
+        for (const auto& entry : FormatTable) {
+            if (entry.format == format) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool isTypedUavStoreSupported(ID3D11Device* device, DXGI_FORMAT format) {
+        D3D11_FEATURE_DATA_FORMAT_SUPPORT2 support{};
+        support.InFormat = format;
+        if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_FORMAT_SUPPORT2, &support, sizeof(support)))) {
+            return false;
+        }
+        return support.OutFormatSupport2 & D3D11_FORMAT_SUPPORT2_UAV_TYPED_STORE;
+    }
+
+    std::optional<StorePlan> chooseStorePlan(const FormatInfo& info,
+                                             const std::function<bool(DXGI_FORMAT)>& isTypedStoreSupported) {
+        if (isTypedStoreSupported(info.uavFormat)) {
+            return StorePlan{info.uavFormat, StoreMode::Typed};
+        }
+        if (info.packedUavFormat != DXGI_FORMAT_UNKNOWN && isTypedStoreSupported(info.packedUavFormat)) {
+            return StorePlan{info.packedUavFormat, info.packedStoreMode};
+        }
+        return {};
+    }
+
+    std::optional<StorePlan> chooseStorePlan(ID3D11Device* device, const FormatInfo& info) {
+        return chooseStorePlan(info, [device](DXGI_FORMAT format) { return isTypedUavStoreSupported(device, format); });
+    }
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+    bool isTypedUavStoreSupported(ID3D12Device* device, DXGI_FORMAT format) {
+        D3D12_FEATURE_DATA_FORMAT_SUPPORT support{};
+        support.Format = format;
+        if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_FORMAT_SUPPORT, &support, sizeof(support)))) {
+            return false;
+        }
+        return support.Support2 & D3D12_FORMAT_SUPPORT2_UAV_TYPED_STORE;
+    }
+
+    std::optional<StorePlan> chooseStorePlan(ID3D12Device* device, const FormatInfo& info) {
+        return chooseStorePlan(info, [device](DXGI_FORMAT format) { return isTypedUavStoreSupported(device, format); });
+    }
+#endif
+
+} // namespace openxr_api_layer::utils::formats
@@ -0,0 +1,104 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::formats {
+
+    // How the post-processing shaders write their output (see shaders/Store.hlsli, the values must match).
+    enum class StoreMode : uint32_t {
+        // Typed UAV store, the hardware converts the float4 result to the view format.
+        Typed = 0,
+
+        // Store through the UINT view of an 8-bit per channel UNORM family. The shader quantizes each channel.
+        PackedUnorm8 = 1,
+
+        // Store through the UINT view of the R10G10B10A2 family. The shader quantizes to 10/10/10/2 bits.
+        PackedUnorm10 = 2,
+    };
+
+    // How color values are encoded in the intermediate textures (see shaders/Store.hlsli, the values must match).
+    enum class ColorEncoding : uint32_t {
+        // Values are used as-is.
+        Linear = 0,
+
+        // sRGB, decoded with the x^2 approximation and re-encoded with sqrt, as suggested by ffx_cas.h.
+        SRGBFast = 1,
+
+        // sRGB, decoded and re-encoded with the exact transfer function.
+        SRGBExact = 2,
+    };
+
+    // Describes how a swapchain format is handled by the post-processing chain.
+    struct FormatInfo {
+        DXGI_FORMAT format;
+
+        // Format of the intermediate textures. It belongs to the same copy family as the swapchain format, and is
+        // typeless whenever the family has more than one view format.
+        DXGI_FORMAT resourceFormat;
+
+        // View formats used to read from and (typed) write to the intermediate textures.
+        DXGI_FORMAT srvFormat;
+        DXGI_FORMAT uavFormat;
+
+        // The UINT view format and store mode to fall back to when the device does not report typed UAV stores to
+        // uavFormat, or DXGI_FORMAT_UNKNOWN if the family has no UINT view (the BGRA/BGRX families, and the float
+        // formats). Reads always go through srvFormat: typed SRV loads are supported for all the formats in this table,
+        // so only the stores need manual packing.
+        DXGI_FORMAT packedUavFormat;
+        StoreMode packedStoreMode;
+
+        bool isSRGB;
+    };
+
+    // Returns the entry for a swapchain format, or nullptr if the format is not supported.
+    const FormatInfo* getFormatInfo(DXGI_FORMAT format);
+
+    // The view format and shader permutation to use for writing to the intermediate textures.
+    struct StorePlan {
+        DXGI_FORMAT uavFormat;
+        StoreMode storeMode;
+    };
+
+    // Pick typed stores when isTypedStoreSupported() accepts uavFormat, otherwise the packed fallback when it accepts
+    // packedUavFormat. Returns nullopt when neither is possible.
+    // Feature level 11_0 requires typed stores to the RGBA8 and R10G10B10A2 UNORM views, but the device is always
+    // queried: it is done once per format, and it keeps the fallback usable on devices that do not honor this.
+    std::optional<StorePlan> chooseStorePlan(const FormatInfo& info,
+                                             const std::function<bool(DXGI_FORMAT)>& isTypedStoreSupported);
+
+    // Same as above, querying a device.
+    std::optional<StorePlan> chooseStorePlan(ID3D11Device* device, const FormatInfo& info);
+
+    bool isTypedUavStoreSupported(ID3D11Device* device, DXGI_FORMAT format);
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+    // Same as above, for D3D12 devices.
+    std::optional<StorePlan> chooseStorePlan(ID3D12Device* device, const FormatInfo& info);
+
+    bool isTypedUavStoreSupported(ID3D12Device* device, DXGI_FORMAT format);
+#endif
+
+} // namespace openxr_api_layer::utils::formats
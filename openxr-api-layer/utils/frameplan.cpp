@@ -0,0 +1,119 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "frameplan.h"
+
+namespace openxr_api_layer::utils::frameplan {
+
+    bool overlaps(const Rect& a, const Rect& b) {
+        if (a.empty() || b.empty()) {
+            return false;
+        }
+        return a.x < b.right() && b.x < a.right() && a.y < b.bottom() && b.y < a.bottom();
+    }
+
+    Rect merge(const Rect& a, const Rect& b) {
+        Rect result;
+        result.x = std::min(a.x, b.x);
+        result.y = std::min(a.y, b.y);
+        result.width = std::max(a.right(), b.right()) - result.x;
+        result.height = std::max(a.bottom(), b.bottom()) - result.y;
+        return result;
+    }
+
+    void FramePlanner::reset() {
+        m_items.clear();
+        m_submittedCount = 0;
+    }
+
+    void FramePlanner::add(const WorkItem& item) {
+        m_submittedCount++;
+        if (item.rect.empty()) {
+            return;
+        }
+        m_items.push_back(item);
+    }
+
+    const std::vector<WorkItem>& FramePlanner::build() {
+        const auto sameTarget = [](const WorkItem& a, const WorkItem& b) {
+            return a.swapchain == b.swapchain && a.imageIndex == b.imageIndex && a.arraySlice == b.arraySlice;
+        };
+
+        std::sort(m_items.begin(), m_items.end(), [](const WorkItem& a, const WorkItem& b) {
+            if (a.swapchain != b.swapchain) {
+                return a.swapchain < b.swapchain;
+            }
+            if (a.imageIndex != b.imageIndex) {
+                return a.imageIndex < b.imageIndex;
+            }
+            if (a.arraySlice != b.arraySlice) {
+                return a.arraySlice < b.arraySlice;
+            }
+            if (a.rect.y != b.rect.y) {
+                return a.rect.y < b.rect.y;
+            }
+            return a.rect.x < b.rect.x;
+        });
+
+        // Merge within each group of items targeting the same image slice. A merge grows a rectangle, which may make it
+        // overlap an item that was previously disjoint, so we iterate until the group is stable. Groups are tiny (one
+        // item per view), so the quadratic search is cheaper than anything smarter.
+        size_t out = 0;
+        for (size_t groupStart = 0; groupStart < m_items.size();) {
+            size_t groupEnd = groupStart + 1;
+            while (groupEnd < m_items.size() && sameTarget(m_items[groupStart], m_items[groupEnd])) {
+                groupEnd++;
+            }
+
+            size_t groupSize = groupEnd - groupStart;
+            bool merged = true;
+            while (merged) {
+                merged = false;
+                for (size_t i = groupStart; i < groupStart + groupSize && !merged; i++) {
+                    for (size_t j = i + 1; j < groupStart + groupSize; j++) {
+                        if (overlaps(m_items[i].rect, m_items[j].rect)) {
+                            m_items[i].rect = merge(m_items[i].rect, m_items[j].rect);
+                            m_items[j] = m_items[groupStart + groupSize - 1];
+                            groupSize--;
+                            merged = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = groupStart; i < groupStart + groupSize; i++) {
+                m_items[out++] = m_items[i];
+            }
+            groupStart = groupEnd;
+        }
+        m_items.resize(out);
+
+        return m_items;
+    }
+
+} // namespace openxr_api_layer::utils::frameplan
@@ -0,0 +1,88 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::frameplan {
+
+    // A pixel rectangle within one array slice of a swapchain image.
+    struct Rect {
+        int32_t x{0};
+        int32_t y{0};
+        int32_t width{0};
+        int32_t height{0};
+
+        int32_t right() const {
+            return x + width;
+        }
+        int32_t bottom() const {
+            return y + height;
+        }
+        bool empty() const {
+            return width <= 0 || height <= 0;
+        }
+    };
+
+    // A unit of post-processing work: one rectangle of one slice of one swapchain image.
+    // The swapchain is an opaque handle value so that the planner does not depend on any graphics API.
+    struct WorkItem {
+        uint64_t swapchain{0};
+        uint32_t imageIndex{0};
+        uint32_t arraySlice{0};
+        Rect rect;
+    };
+
+    // Returns true if both rectangles share at least one pixel. Rectangles that only touch along an edge do not
+    // overlap (eg: the two halves of a side-by-side stereo texture).
+    bool overlaps(const Rect& a, const Rect& b);
+
+    // Returns the smallest rectangle containing both rectangles.
+    Rect merge(const Rect& a, const Rect& b);
+
+    // Collects all the work items submitted for a frame (across all composition layers and views), and reduces them to
+    // a list where each texel is covered by exactly one item:
+    // - items targeting the same swapchain image and array slice with overlapping rectangles are merged into their
+    //   bounding rectangle (repeated until no overlap remains),
+    // - identical items are collapsed.
+    // The planner does not release its storage between frames, so steady-state planning does not allocate.
+    class FramePlanner {
+      public:
+        void reset();
+        void add(const WorkItem& item);
+
+        // Reduce the collected items. The returned list is ordered by swapchain, image index and array slice.
+        const std::vector<WorkItem>& build();
+
+        // Number of items passed to add() since the last reset().
+        uint32_t getSubmittedCount() const {
+            return m_submittedCount;
+        }
+
+      private:
+        std::vector<WorkItem> m_items;
+        uint32_t m_submittedCount{0};
+    };
+
+} // namespace openxr_api_layer::utils::frameplan
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "general.h"
+#include "timeline.h"
 
 namespace openxr_api_layer::utils::graphics {
 
@@ -82,17 +83,13 @@ namespace openxr_api_layer::utils::graphics {
     };
 
     // A fence.
-    struct IGraphicsFence {
+    struct IGraphicsFence : openxr_api_layer::utils::timeline::IFence {
         virtual ~IGraphicsFence() = default;
 
         virtual Api getApi() const = 0;
         virtual void* getNativeFencePtr() const = 0;
         virtual ShareableHandle getFenceHandle() const = 0;
 
-        virtual void signal(uint64_t value) = 0;
-        virtual void waitOnDevice(uint64_t value) = 0;
-        virtual void waitOnCpu(uint64_t value) = 0;
-
         virtual bool isShareable() const = 0;
 
         template <typename ApiTraits>
@@ -193,11 +190,25 @@ namespace openxr_api_layer::utils::graphics {
 
     struct ISwapchainImage;
 
+    // How the images of a swapchain are made available on the composition device.
+    struct SwapchainStats {
+        // Images opened directly on the composition device, and images that could not be and are copied through a
+        // bounce buffer instead.
+        uint32_t sharedImages;
+        uint32_t bounceBufferedImages;
+
+        // Bytes copied through the bounce buffer, in total and since the most recent image acquisition.
+        uint64_t bytesCopied;
+        uint64_t bytesCopiedLastFrame;
+    };
+
     // A swapchain.
     struct ISwapchain {
         virtual ~ISwapchain() = default;
 
         // Only for manipulating swapchains created through createSwapchain().
+        // For a non-submittable swapchain, returns nullptr rather than blocking when all the images are held by the
+        // caller. When wait is false, the image might still be in use by the GPU until waitImage() is called.
         virtual ISwapchainImage* acquireImage(bool wait = true) = 0;
         virtual void waitImage() = 0;
         virtual void releaseImage() = 0;
@@ -209,6 +220,7 @@ namespace openxr_api_layer::utils::graphics {
         virtual int64_t getFormatOnApplicationDevice() const = 0;
         virtual ISwapchainImage* getImage(uint32_t index) const = 0;
         virtual uint32_t getLength() const = 0;
+        virtual SwapchainStats getStats() const = 0;
 
         // Can only be called if the swapchain is submittable.
         virtual XrSwapchain getSwapchainHandle() const = 0;
@@ -243,8 +255,10 @@ namespace openxr_api_layer::utils::graphics {
         virtual ICompositionSessionData* getSessionDataPtr() const = 0;
 
         // Create a swapchain without an XrSwapchain handle.
+        // The number of images (at least 2) only applies to non-submittable swapchains, the runtime decides otherwise.
         virtual std::shared_ptr<ISwapchain> createSwapchain(const XrSwapchainCreateInfo& infoOnApplicationDevice,
-                                                            SwapchainMode mode) = 0;
+                                                            SwapchainMode mode,
+                                                            uint32_t imageCount = 2) = 0;
 
         // (Not used in this minimal layer)
         // virtual std::shared_ptr<ISwapchain> wrapSwapchain(XrSwapchain swapchain,
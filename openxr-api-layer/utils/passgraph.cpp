@@ -0,0 +1,166 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "passgraph.h"
+
+namespace openxr_api_layer::utils::passgraph {
+
+    void PassGraph::reset() {
+        m_resources.clear();
+        m_passes.clear();
+        m_importCount = 0;
+        m_steps.clear();
+        m_barriers.clear();
+    }
+
+    ResourceId PassGraph::importTexture() {
+        const ResourceId id = (ResourceId)m_resources.size();
+        m_resources.push_back({Texture::Imported, 0, id, -1, -1, {Texture::Imported, m_importCount++}});
+        return id;
+    }
+
+    ResourceId PassGraph::createTransient(uint32_t sizeClass) {
+        const ResourceId id = (ResourceId)m_resources.size();
+        m_resources.push_back({sizeClass, 0, id, -1, -1, {}});
+        return id;
+    }
+
+    void PassGraph::addPass(uint32_t tag, PassKind kind, ResourceId input, ResourceId output, bool enabled) {
+        m_passes.push_back({tag, kind, input, output, enabled, false});
+    }
+
+    ResourceId PassGraph::resolve(ResourceId id) const {
+        while (m_resources[id].alias != id) {
+            id = m_resources[id].alias;
+        }
+        return id;
+    }
+
+    bool PassGraph::compile() {
+        m_steps.clear();
+        m_barriers.clear();
+        m_accesses.clear();
+        for (auto& inUse : m_inUse) {
+            inUse.clear();
+        }
+
+        // Find the writer of each transient resource, and forward the resources of the disabled passes to their input.
+        for (int32_t i = 0; i < (int32_t)m_passes.size(); i++) {
+            const Pass& pass = m_passes[i];
+            const Resource& input = m_resources[resolve(pass.input)];
+            if (input.sizeClass != Texture::Imported && input.writer < 0) {
+                return false;
+            }
+            Resource& output = m_resources[pass.output];
+            if (output.sizeClass == Texture::Imported) {
+                continue;
+            }
+            if (output.writer >= 0) {
+                return false;
+            }
+            output.writer = i;
+            if (!pass.enabled) {
+                output.alias = resolve(pass.input);
+            }
+            if (m_inUse.size() <= output.sizeClass) {
+                m_inUse.resize(output.sizeClass + 1);
+            }
+        }
+
+        // Walk back from the imported textures: a pass is live if an imported texture or a live pass reads its result.
+        // The first live reader met is the last one to execute.
+        for (int32_t i = (int32_t)m_passes.size() - 1; i >= 0; i--) {
+            Pass& pass = m_passes[i];
+            const Resource& output = m_resources[pass.output];
+            pass.live = pass.enabled && (output.sizeClass == Texture::Imported || output.lastReader >= 0);
+            if (pass.live) {
+                Resource& input = m_resources[resolve(pass.input)];
+                if (input.lastReader < 0) {
+                    input.lastReader = i;
+                }
+            }
+        }
+
+        const auto access = [&](const Texture& texture, Access after) {
+            auto it = std::find_if(m_accesses.begin(), m_accesses.end(), [&](const auto& entry) {
+                return entry.first == texture;
+            });
+            const Access before = it != m_accesses.end() ? it->second : Access::None;
+            if (before != after) {
+                m_barriers.push_back({texture, before, after});
+            }
+            if (it != m_accesses.end()) {
+                it->second = after;
+            } else {
+                m_accesses.emplace_back(texture, after);
+            }
+        };
+
+        // Place each result in the first free texture of its size class. The input is still in use at that point, so
+        // a pass never writes where it reads, and it is released right after its last reader.
+        for (int32_t i = 0; i < (int32_t)m_passes.size(); i++) {
+            const Pass& pass = m_passes[i];
+            if (!pass.live) {
+                continue;
+            }
+            Resource& input = m_resources[resolve(pass.input)];
+            Resource& output = m_resources[pass.output];
+            if (output.sizeClass != Texture::Imported) {
+                auto& inUse = m_inUse[output.sizeClass];
+                const auto freeIt = std::find(inUse.begin(), inUse.end(), false);
+                output.index = (uint32_t)(freeIt - inUse.begin());
+                if (freeIt == inUse.end()) {
+                    inUse.push_back(true);
+                } else {
+                    *freeIt = true;
+                }
+                output.texture = {output.sizeClass, output.index};
+            }
+
+            const uint32_t firstBarrier = (uint32_t)m_barriers.size();
+            access(input.texture, pass.kind == PassKind::Copy ? Access::CopySource : Access::ShaderRead);
+            access(output.texture, pass.kind == PassKind::Copy ? Access::CopyDest : Access::ShaderWrite);
+            m_steps.push_back({pass.tag,
+                               pass.kind,
+                               input.texture,
+                               output.texture,
+                               firstBarrier,
+                               (uint32_t)m_barriers.size() - firstBarrier});
+
+            if (input.sizeClass != Texture::Imported && input.lastReader == i) {
+                m_inUse[input.sizeClass][input.index] = false;
+            }
+        }
+
+        return true;
+    }
+
+    uint32_t PassGraph::getTextureCount(uint32_t sizeClass) const {
+        return sizeClass < m_inUse.size() ? (uint32_t)m_inUse[sizeClass].size() : 0;
+    }
+
+} // namespace openxr_api_layer::utils::passgraph
@@ -0,0 +1,130 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::passgraph {
+
+    // How a pass uses a texture. A change between two passes needs a barrier on D3D12 and an unbind on D3D11.
+    enum class Access : uint8_t { None = 0, CopySource, CopyDest, ShaderRead, ShaderWrite };
+
+    enum class PassKind : uint8_t { Copy = 0, Compute };
+
+    using ResourceId = uint32_t;
+
+    // Where the contents of a resource live once the graph is compiled: an imported texture, or one of the pooled
+    // textures of a size class.
+    struct Texture {
+        static constexpr uint32_t Imported = ~0u;
+
+        uint32_t sizeClass{Imported};
+        uint32_t index{0};
+
+        bool isImported() const {
+            return sizeClass == Imported;
+        }
+        bool operator==(const Texture& other) const {
+            return sizeClass == other.sizeClass && index == other.index;
+        }
+    };
+
+    struct Barrier {
+        Texture texture;
+        Access before;
+        Access after;
+    };
+
+    // A pass that survived compilation, in execution order. Its barriers come first.
+    struct Step {
+        uint32_t tag;
+        PassKind kind;
+        Texture input;
+        Texture output;
+        uint32_t firstBarrier;
+        uint32_t barrierCount;
+    };
+
+    // A small render graph for the post-processing chain. Passes are declared in order, each reading one resource and
+    // writing a new one. Intermediate results are transient resources of a size class (eg: the source or the output
+    // resolution), which compile() maps onto as few pooled textures as their lifetimes allow: a chain of passes ping-
+    // pongs between two textures. The ends of the chain are imported textures (the swapchain images).
+    // Disabled passes are bypassed, their readers read their input instead, and passes whose result does not reach an
+    // imported texture are culled. compile() is pure CPU work and does not release its storage between frames.
+    class PassGraph {
+      public:
+        void reset();
+
+        ResourceId importTexture();
+        ResourceId createTransient(uint32_t sizeClass);
+
+        // The tag is the caller's identifier of the pass, found back in the steps.
+        void addPass(uint32_t tag, PassKind kind, ResourceId input, ResourceId output, bool enabled = true);
+
+        // Returns false if a pass reads a transient resource that no earlier pass writes, or writes one twice.
+        bool compile();
+
+        const std::vector<Step>& getSteps() const {
+            return m_steps;
+        }
+        const std::vector<Barrier>& getBarriers() const {
+            return m_barriers;
+        }
+
+        // Number of pooled textures the compiled graph needs in a size class.
+        uint32_t getTextureCount(uint32_t sizeClass) const;
+
+      private:
+        struct Resource {
+            uint32_t sizeClass;
+            uint32_t index;
+            ResourceId alias;
+            int32_t writer;
+            int32_t lastReader;
+            Texture texture;
+        };
+        struct Pass {
+            uint32_t tag;
+            PassKind kind;
+            ResourceId input;
+            ResourceId output;
+            bool enabled;
+            bool live;
+        };
+
+        ResourceId resolve(ResourceId id) const;
+
+        std::vector<Resource> m_resources;
+        std::vector<Pass> m_passes;
+        uint32_t m_importCount{0};
+
+        std::vector<Step> m_steps;
+        std::vector<Barrier> m_barriers;
+
+        // Per size class, whether each pooled texture is in use, and per pooled texture, its last access.
+        std::vector<std::vector<bool>> m_inUse;
+        std::vector<std::pair<Texture, Access>> m_accesses;
+    };
+
+} // namespace openxr_api_layer::utils::passgraph
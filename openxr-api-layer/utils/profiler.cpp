@@ -0,0 +1,169 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "profiler.h"
+
+#include "log.h"
+
+namespace {
+
+    using namespace openxr_api_layer::utils::profiler;
+
+    struct Event {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Written by its thread only. The exporter reads it concurrently, and discards what may have been overwritten
+    // while it was copying.
+    struct Ring {
+        static constexpr uint32_t Capacity = 16384;
+
+        Event events[Capacity];
+        std::atomic<uint64_t> written{0};
+        DWORD threadId{0};
+        std::string threadName;
+    };
+
+    std::atomic<bool> g_enabled{false};
+
+    // Rings outlive their thread, so that the events of a finished thread can still be exported.
+    std::mutex g_ringsMutex;
+    std::vector<std::unique_ptr<Ring>> g_rings;
+
+    Ring* getThreadRing() {
+        thread_local Ring* ring = nullptr;
+        if (!ring) {
+            auto newRing = std::make_unique<Ring>();
+            newRing->threadId = GetCurrentThreadId();
+            PWSTR description = nullptr;
+            if (SUCCEEDED(GetThreadDescription(GetCurrentThread(), &description)) && description) {
+                const std::wstring name(description);
+                newRing->threadName.assign(name.begin(), name.end());
+                LocalFree(description);
+            }
+            ring = newRing.get();
+            std::unique_lock lock(g_ringsMutex);
+            g_rings.push_back(std::move(newRing));
+        }
+        return ring;
+    }
+
+    std::string escapeJson(const std::string& str) {
+        std::string escaped;
+        for (const char c : str) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            if ((unsigned char)c >= 0x20) {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+} // namespace
+
+namespace openxr_api_layer::utils::profiler {
+
+    using namespace openxr_api_layer::log;
+
+    void setEnabled(bool enabled) {
+        g_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool isEnabled() {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void record(const char* name, uint64_t beginUs, uint64_t endUs) {
+        Ring* ring = getThreadRing();
+        const uint64_t index = ring->written.load(std::memory_order_relaxed);
+        ring->events[index % Ring::Capacity] = {name, beginUs, endUs};
+        ring->written.store(index + 1, std::memory_order_release);
+    }
+
+    bool exportChromeTrace(const std::filesystem::path& path) {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            ErrorLog(fmt::format("Failed to write trace: {}\n", path.string()));
+            return false;
+        }
+
+        const DWORD pid = GetCurrentProcessId();
+        size_t eventCount = 0;
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        std::unique_lock lock(g_ringsMutex);
+        for (const auto& ring : g_rings) {
+            if (!ring->threadName.empty()) {
+                out << (first ? "" : ",") << "\n"
+                    << fmt::format(R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"{}"}}}})",
+                                   pid,
+                                   ring->threadId,
+                                   escapeJson(ring->threadName));
+                first = false;
+            }
+
+            const uint64_t before = ring->written.load(std::memory_order_acquire);
+            const uint64_t start = before > Ring::Capacity ? before - Ring::Capacity : 0;
+            std::vector<Event> events;
+            events.reserve(before - start);
+            for (uint64_t i = start; i < before; i++) {
+                events.push_back(ring->events[i % Ring::Capacity]);
+            }
+
+            // Drop the oldest events if the thread wrapped around onto them during the copy.
+            const uint64_t after = ring->written.load(std::memory_order_acquire);
+            const uint64_t overwritten = after > before ? std::min<uint64_t>(after - before, events.size()) : 0;
+            for (size_t i = overwritten; i < events.size(); i++) {
+                const Event& event = events[i];
+                out << (first ? "" : ",") << "\n"
+                    << fmt::format(R"({{"name":"{}","ph":"X","pid":{},"tid":{},"ts":{},"dur":{}}})",
+                                   event.name,
+                                   pid,
+                                   ring->threadId,
+                                   event.begin,
+                                   event.end - event.begin);
+                first = false;
+                eventCount++;
+            }
+        }
+        out << "\n]}\n";
+
+        Log(fmt::format("Wrote {} trace events to {}\n", eventCount, path.string()));
+        return true;
+    }
+
+} // namespace openxr_api_layer::utils::profiler
@@ -0,0 +1,66 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::profiler {
+
+    // Lightweight CPU profiling: scopes are recorded in per-thread ring buffers and exported as Chrome trace JSON,
+    // which chrome://tracing and ui.perfetto.dev can open. While disabled, a Scope costs a single atomic load.
+
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    // Microseconds on a monotonic clock.
+    uint64_t now();
+
+    void record(const char* name, uint64_t beginUs, uint64_t endUs);
+
+    // Write the events still held by the ring buffers. Returns false if the file cannot be written.
+    bool exportChromeTrace(const std::filesystem::path& path);
+
+    // Times the enclosing block. name must be a string literal (it is stored, not copied).
+    class Scope {
+      public:
+        explicit Scope(const char* name) : m_name(isEnabled() ? name : nullptr) {
+            if (m_name) {
+                m_begin = now();
+            }
+        }
+        ~Scope() {
+            if (m_name) {
+                record(m_name, m_begin, now());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+      private:
+        const char* const m_name;
+        uint64_t m_begin{0};
+    };
+
+} // namespace openxr_api_layer::utils::profiler
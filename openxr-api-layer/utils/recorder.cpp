@@ -0,0 +1,264 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "recorder.h"
+
+namespace openxr_api_layer::utils::recorder {
+
+    namespace {
+
+        // Never a valid handle, so that a binding compared against it is always issued.
+        const Handle Unknown = reinterpret_cast<Handle>(~uintptr_t(0));
+
+#ifdef XR_USE_GRAPHICS_API_D3D11
+        struct D3D11ComputeBindings : IComputeBindings {
+            explicit D3D11ComputeBindings(ID3D11DeviceContext* context) : m_context(context) {
+            }
+
+            void setShader(Handle shader) override {
+                m_context->CSSetShader(static_cast<ID3D11ComputeShader*>(shader), nullptr, 0);
+            }
+
+            void setConstantBuffers(uint32_t startSlot, uint32_t count, const Handle* buffers) override {
+                ID3D11Buffer* d3dBuffers[StateRecorder::MaxSlots]{};
+                for (uint32_t i = 0; i < count; i++) {
+                    d3dBuffers[i] = static_cast<ID3D11Buffer*>(buffers[i]);
+                }
+                m_context->CSSetConstantBuffers(startSlot, count, d3dBuffers);
+            }
+
+            void setShaderResources(uint32_t startSlot, uint32_t count, const Handle* views) override {
+                ID3D11ShaderResourceView* srvs[StateRecorder::MaxSlots]{};
+                for (uint32_t i = 0; i < count; i++) {
+                    srvs[i] = static_cast<ID3D11ShaderResourceView*>(views[i]);
+                }
+                m_context->CSSetShaderResources(startSlot, count, srvs);
+            }
+
+            void setUnorderedAccessViews(uint32_t startSlot, uint32_t count, const Handle* views) override {
+                ID3D11UnorderedAccessView* uavs[StateRecorder::MaxSlots]{};
+                for (uint32_t i = 0; i < count; i++) {
+                    uavs[i] = static_cast<ID3D11UnorderedAccessView*>(views[i]);
+                }
+                const UINT initialCounts[StateRecorder::MaxSlots]{};
+                m_context->CSSetUnorderedAccessViews(startSlot, count, uavs, initialCounts);
+            }
+
+            void dispatch(uint32_t x, uint32_t y, uint32_t z) override {
+                m_context->Dispatch(x, y, z);
+            }
+
+            const Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_context;
+        };
+#endif
+
+    } // namespace
+
+#ifdef XR_USE_GRAPHICS_API_D3D11
+    std::unique_ptr<IComputeBindings> createD3D11ComputeBindings(ID3D11DeviceContext* context) {
+        return std::make_unique<D3D11ComputeBindings>(context);
+    }
+#endif
+
+    StateRecorder::StateRecorder(std::unique_ptr<IComputeBindings> bindings) : m_bindings(std::move(bindings)) {
+        invalidate();
+    }
+
+    void StateRecorder::invalidate() {
+        m_shader = Unknown;
+        for (uint32_t i = 0; i < MaxSlots; i++) {
+            m_constantBuffers[i] = Unknown;
+            m_shaderResources[i] = Unknown;
+            m_unorderedAccessViews[i] = Unknown;
+            m_pendingShaderResources[i] = nullptr;
+            m_pendingUnorderedAccessViews[i] = nullptr;
+        }
+    }
+
+    void StateRecorder::setShader(Handle shader) {
+        m_stats.requested++;
+        if (shader != m_shader) {
+            m_bindings->setShader(shader);
+            m_shader = shader;
+            m_stats.issued++;
+        }
+    }
+
+    void StateRecorder::setConstantBuffers(uint32_t startSlot, uint32_t count, const Handle* buffers) {
+        m_stats.requested++;
+
+        // Forward only the range of slots that changed.
+        uint32_t first = count, last = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (buffers[i] != m_constantBuffers[startSlot + i]) {
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+        if (first == count) {
+            return;
+        }
+        m_bindings->setConstantBuffers(startSlot + first, last - first + 1, buffers + first);
+        for (uint32_t i = first; i <= last; i++) {
+            m_constantBuffers[startSlot + i] = buffers[i];
+        }
+        m_stats.issued++;
+    }
+
+    void StateRecorder::setShaderResource(uint32_t slot, Handle view) {
+        m_stats.requested++;
+        m_pendingShaderResources[slot] = view;
+    }
+
+    void StateRecorder::setUnorderedAccessView(uint32_t slot, Handle view) {
+        m_stats.requested++;
+        m_pendingUnorderedAccessViews[slot] = view;
+    }
+
+    void StateRecorder::dispatch(uint32_t x, uint32_t y, uint32_t z) {
+        flushResources();
+        m_bindings->dispatch(x, y, z);
+    }
+
+    void StateRecorder::unbindResources() {
+        m_stats.requested += 2;
+        for (uint32_t i = 0; i < MaxSlots; i++) {
+            m_pendingShaderResources[i] = nullptr;
+            m_pendingUnorderedAccessViews[i] = nullptr;
+        }
+        flushResources();
+    }
+
+    template <typename Bind>
+    void StateRecorder::flushRange(Handle (&bound)[MaxSlots], const Handle (&pending)[MaxSlots], Bind&& bind) {
+        uint32_t first = MaxSlots, last = 0;
+        for (uint32_t i = 0; i < MaxSlots; i++) {
+            if (pending[i] != bound[i]) {
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+        if (first == MaxSlots) {
+            return;
+        }
+        bind(first, last - first + 1, pending + first);
+        for (uint32_t i = first; i <= last; i++) {
+            bound[i] = pending[i];
+        }
+        m_stats.issued++;
+    }
+
+    void StateRecorder::flushResources() {
+        // A texture read by one pass is typically written by the next. Binding the new UAVs while the old SRVs are
+        // still bound would have the runtime silently unbind them, so the SRVs that change are cleared first.
+        bool srvsChange = false, uavsChange = false;
+        for (uint32_t i = 0; i < MaxSlots; i++) {
+            srvsChange = srvsChange || m_pendingShaderResources[i] != m_shaderResources[i];
+            uavsChange = uavsChange || m_pendingUnorderedAccessViews[i] != m_unorderedAccessViews[i];
+        }
+        if (srvsChange && uavsChange) {
+            Handle cleared[MaxSlots];
+            for (uint32_t i = 0; i < MaxSlots; i++) {
+                cleared[i] = m_pendingShaderResources[i] != m_shaderResources[i] ? nullptr : m_shaderResources[i];
+            }
+            flushRange(m_shaderResources, cleared, [&](uint32_t start, uint32_t count, const Handle* views) {
+                m_bindings->setShaderResources(start, count, views);
+            });
+        }
+        flushRange(m_unorderedAccessViews,
+                   m_pendingUnorderedAccessViews,
+                   [&](uint32_t start, uint32_t count, const Handle* views) {
+                       m_bindings->setUnorderedAccessViews(start, count, views);
+                   });
+        flushRange(m_shaderResources, m_pendingShaderResources, [&](uint32_t start, uint32_t count, const Handle* views) {
+            m_bindings->setShaderResources(start, count, views);
+        });
+    }
+
+#ifdef XR_USE_GRAPHICS_API_D3D11
+    void ComputeStateSnapshot::capture(ID3D11DeviceContext* context) {
+        ID3D11ClassInstance* classInstances[D3D11_SHADER_MAX_INTERFACES]{};
+        UINT numClassInstances = D3D11_SHADER_MAX_INTERFACES;
+        context->CSGetShader(m_shader.ReleaseAndGetAddressOf(), classInstances, &numClassInstances);
+        m_classInstances.clear();
+        for (UINT i = 0; i < numClassInstances; i++) {
+            // The getter added a reference, which the ComPtr takes over.
+            m_classInstances.emplace_back().Attach(classInstances[i]);
+        }
+
+        ID3D11Buffer* buffers[StateRecorder::MaxSlots]{};
+        ID3D11ShaderResourceView* srvs[StateRecorder::MaxSlots]{};
+        ID3D11UnorderedAccessView* uavs[StateRecorder::MaxSlots]{};
+        context->CSGetConstantBuffers(0, StateRecorder::MaxSlots, buffers);
+        context->CSGetShaderResources(0, StateRecorder::MaxSlots, srvs);
+        context->CSGetUnorderedAccessViews(0, StateRecorder::MaxSlots, uavs);
+        for (uint32_t i = 0; i < StateRecorder::MaxSlots; i++) {
+            m_constantBuffers[i].Attach(buffers[i]);
+            m_shaderResources[i].Attach(srvs[i]);
+            m_unorderedAccessViews[i].Attach(uavs[i]);
+        }
+        m_captured = true;
+    }
+
+    void ComputeStateSnapshot::restore(ID3D11DeviceContext* context) {
+        if (!m_captured) {
+            return;
+        }
+
+        ID3D11ClassInstance* classInstances[D3D11_SHADER_MAX_INTERFACES]{};
+        for (size_t i = 0; i < m_classInstances.size(); i++) {
+            classInstances[i] = m_classInstances[i].Get();
+        }
+        context->CSSetShader(m_shader.Get(), classInstances, (UINT)m_classInstances.size());
+
+        ID3D11Buffer* buffers[StateRecorder::MaxSlots]{};
+        ID3D11ShaderResourceView* srvs[StateRecorder::MaxSlots]{};
+        ID3D11UnorderedAccessView* uavs[StateRecorder::MaxSlots]{};
+        for (uint32_t i = 0; i < StateRecorder::MaxSlots; i++) {
+            buffers[i] = m_constantBuffers[i].Get();
+            srvs[i] = m_shaderResources[i].Get();
+            uavs[i] = m_unorderedAccessViews[i].Get();
+        }
+        // -1 keeps the hidden counters of the UAVs as they are.
+        UINT keepCounts[StateRecorder::MaxSlots];
+        std::fill(std::begin(keepCounts), std::end(keepCounts), UINT(-1));
+        context->CSSetUnorderedAccessViews(0, StateRecorder::MaxSlots, uavs, keepCounts);
+        context->CSSetShaderResources(0, StateRecorder::MaxSlots, srvs);
+        context->CSSetConstantBuffers(0, StateRecorder::MaxSlots, buffers);
+
+        m_shader.Reset();
+        m_classInstances.clear();
+        for (uint32_t i = 0; i < StateRecorder::MaxSlots; i++) {
+            m_constantBuffers[i].Reset();
+            m_shaderResources[i].Reset();
+            m_unorderedAccessViews[i].Reset();
+        }
+        m_captured = false;
+    }
+#endif
+
+} // namespace openxr_api_layer::utils::recorder
@@ -0,0 +1,129 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::recorder {
+
+    // Opaque handle to a shader, constant buffer or view of the underlying API.
+    using Handle = void*;
+
+    // The compute pipeline calls a StateRecorder forwards. Implemented over a D3D11 context, or by a mock that records
+    // the calls.
+    struct IComputeBindings {
+        virtual ~IComputeBindings() = default;
+
+        virtual void setShader(Handle shader) = 0;
+        virtual void setConstantBuffers(uint32_t startSlot, uint32_t count, const Handle* buffers) = 0;
+        virtual void setShaderResources(uint32_t startSlot, uint32_t count, const Handle* views) = 0;
+        virtual void setUnorderedAccessViews(uint32_t startSlot, uint32_t count, const Handle* views) = 0;
+        virtual void dispatch(uint32_t x, uint32_t y, uint32_t z) = 0;
+    };
+
+#ifdef XR_USE_GRAPHICS_API_D3D11
+    std::unique_ptr<IComputeBindings> createD3D11ComputeBindings(ID3D11DeviceContext* context);
+#endif
+
+    // Tracks the compute bindings and only forwards the ones that change. Resource views are applied lazily at
+    // dispatch(), so that unbinding between passes costs nothing when the next pass binds new views anyway.
+    class StateRecorder {
+      public:
+        static constexpr uint32_t MaxSlots = 4;
+
+        // Binding calls made to the recorder vs. calls forwarded to the API.
+        struct Stats {
+            uint64_t requested{0};
+            uint64_t issued{0};
+
+            uint64_t elided() const {
+                return requested > issued ? requested - issued : 0;
+            }
+        };
+
+        explicit StateRecorder(std::unique_ptr<IComputeBindings> bindings);
+
+        // Forget what is bound, for example after the application used the context. The next bindings are always
+        // issued.
+        void invalidate();
+
+        void setShader(Handle shader);
+        void setConstantBuffers(uint32_t startSlot, uint32_t count, const Handle* buffers);
+        void setShaderResource(uint32_t slot, Handle view);
+        void setUnorderedAccessView(uint32_t slot, Handle view);
+        void dispatch(uint32_t x, uint32_t y, uint32_t z);
+
+        // Unbind all resource views now, with at most one call per view type.
+        void unbindResources();
+
+        const Stats& getStats() const {
+            return m_stats;
+        }
+        void resetStats() {
+            m_stats = {};
+        }
+
+      private:
+        void flushResources();
+
+        // Call bind() once for the range of slots where pending differs from bound, then mark them as bound.
+        template <typename Bind>
+        void flushRange(Handle (&bound)[MaxSlots], const Handle (&pending)[MaxSlots], Bind&& bind);
+
+        std::unique_ptr<IComputeBindings> m_bindings;
+
+        // Bindings as seen by the API, or Unknown.
+        Handle m_shader;
+        Handle m_constantBuffers[MaxSlots];
+        Handle m_shaderResources[MaxSlots];
+        Handle m_unorderedAccessViews[MaxSlots];
+
+        // Views requested since the last dispatch.
+        Handle m_pendingShaderResources[MaxSlots]{};
+        Handle m_pendingUnorderedAccessViews[MaxSlots]{};
+
+        Stats m_stats;
+    };
+
+#ifdef XR_USE_GRAPHICS_API_D3D11
+    // The application's compute bindings in the slots a StateRecorder may touch, so they can be put back after the
+    // layer's passes. Much cheaper than saving the whole pipeline state.
+    class ComputeStateSnapshot {
+      public:
+        void capture(ID3D11DeviceContext* context);
+
+        // Restore the captured bindings and release them.
+        void restore(ID3D11DeviceContext* context);
+
+      private:
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader> m_shader;
+        std::vector<Microsoft::WRL::ComPtr<ID3D11ClassInstance>> m_classInstances;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> m_constantBuffers[StateRecorder::MaxSlots];
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_shaderResources[StateRecorder::MaxSlots];
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> m_unorderedAccessViews[StateRecorder::MaxSlots];
+        bool m_captured{false};
+    };
+#endif
+
+} // namespace openxr_api_layer::utils::recorder
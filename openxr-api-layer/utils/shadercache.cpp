@@ -0,0 +1,191 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "shadercache.h"
+
+#include "log.h"
+
+namespace {
+
+    // Pack file layout: a header, then the entry table, then the blobs.
+    constexpr uint32_t PackMagic = 0x43534358; // 'XCSC'
+    constexpr uint32_t PackVersion = 1;
+
+    struct PackHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+    };
+
+    struct PackEntry {
+        uint64_t key;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+} // namespace
+
+namespace openxr_api_layer::utils::shadercache {
+
+    using namespace openxr_api_layer::log;
+
+    uint64_t hash(const void* data, size_t size, uint64_t seed) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        uint64_t h = seed;
+        for (size_t i = 0; i < size; i++) {
+            h ^= bytes[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    void ShaderCache::open(const std::filesystem::path& path) {
+        close();
+        m_path = path;
+
+        m_file.reset(CreateFileW(path.c_str(),
+                                 GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                 nullptr,
+                                 OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                 nullptr));
+        if (!m_file) {
+            return;
+        }
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(m_file.get(), &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(PackHeader)) {
+            close();
+            return;
+        }
+        m_mapping.reset(CreateFileMappingW(m_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        if (!m_mapping) {
+            close();
+            return;
+        }
+        m_view.reset(MapViewOfFile(m_mapping.get(), FILE_MAP_READ, 0, 0, 0));
+        if (!m_view) {
+            close();
+            return;
+        }
+        m_viewSize = (size_t)fileSize.QuadPart;
+
+        const uint8_t* base = reinterpret_cast<const uint8_t*>(m_view.get());
+        const PackHeader* header = reinterpret_cast<const PackHeader*>(base);
+        const size_t tableEnd = sizeof(PackHeader) + (size_t)header->entryCount * sizeof(PackEntry);
+        if (header->magic != PackMagic || header->version != PackVersion || tableEnd > m_viewSize) {
+            Log(fmt::format("Shader cache {} is invalid, ignoring it\n", path.string()));
+            close();
+            return;
+        }
+        const PackEntry* entries = reinterpret_cast<const PackEntry*>(base + sizeof(PackHeader));
+        for (uint32_t i = 0; i < header->entryCount; i++) {
+            if (entries[i].offset < tableEnd || (size_t)entries[i].offset + entries[i].size > m_viewSize) {
+                continue;
+            }
+            m_index.insert_or_assign(entries[i].key, Blob{base + entries[i].offset, entries[i].size});
+        }
+        Log(fmt::format("Shader cache: {} entries from {}\n", m_index.size(), path.string()));
+    }
+
+    Blob ShaderCache::find(uint64_t key) const {
+        const auto it = m_index.find(key);
+        return it != m_index.end() ? it->second : Blob{};
+    }
+
+    void ShaderCache::store(uint64_t key, const void* data, size_t size) {
+        auto& bytes = m_pending[key];
+        bytes.assign(reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + size);
+        m_index.insert_or_assign(key, Blob{bytes.data(), bytes.size()});
+    }
+
+    bool ShaderCache::flush() {
+        if (m_pending.empty() || m_path.empty()) {
+            return true;
+        }
+
+        // Serialize everything first: the mapping must be released before the file can be replaced.
+        std::vector<PackEntry> entries;
+        entries.reserve(m_index.size());
+        uint32_t offset = (uint32_t)(sizeof(PackHeader) + m_index.size() * sizeof(PackEntry));
+        for (const auto& [key, blob] : m_index) {
+            entries.push_back({key, offset, (uint32_t)blob.size});
+            offset += (uint32_t)blob.size;
+        }
+        std::vector<uint8_t> content(offset);
+        const PackHeader header{PackMagic, PackVersion, (uint32_t)entries.size(), 0};
+        memcpy(content.data(), &header, sizeof(header));
+        memcpy(content.data() + sizeof(header), entries.data(), entries.size() * sizeof(PackEntry));
+        for (const auto& entry : entries) {
+            const Blob& blob = m_index[entry.key];
+            memcpy(content.data() + entry.offset, blob.data, blob.size);
+        }
+
+        // Write to a temporary file and swap it in, so that a concurrent reader never sees a partial file.
+        const std::filesystem::path path = m_path;
+        close();
+        bool written = false;
+        std::filesystem::path tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (out) {
+                out.write(reinterpret_cast<const char*>(content.data()), content.size());
+                written = out.good();
+            }
+        }
+        if (written) {
+            written = MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+        }
+        if (!written) {
+            ErrorLog(fmt::format("Failed to write shader cache {}\n", path.string()));
+        }
+
+        // Reopen, falling back to the serialized content if the file could not be replaced.
+        open(path);
+        if (!written) {
+            PackEntry* table = reinterpret_cast<PackEntry*>(content.data() + sizeof(PackHeader));
+            for (uint32_t i = 0; i < header.entryCount; i++) {
+                if (m_index.find(table[i].key) == m_index.end()) {
+                    store(table[i].key, content.data() + table[i].offset, table[i].size);
+                }
+            }
+        }
+        return written;
+    }
+
+    void ShaderCache::close() {
+        m_index.clear();
+        m_pending.clear();
+        m_view.reset();
+        m_mapping.reset();
+        m_file.reset();
+        m_viewSize = 0;
+    }
+
+} // namespace openxr_api_layer::utils::shadercache
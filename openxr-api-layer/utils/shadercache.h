@@ -0,0 +1,77 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::shadercache {
+
+    constexpr uint64_t FnvOffsetBasis = 14695981039346656037ull;
+
+    // 64-bit FNV-1a. Chain calls by passing the previous result as the seed.
+    uint64_t hash(const void* data, size_t size, uint64_t seed = FnvOffsetBasis);
+    static inline uint64_t hashString(const std::string& str, uint64_t seed = FnvOffsetBasis) {
+        return hash(str.data(), str.size(), seed);
+    }
+
+    struct Blob {
+        const void* data{nullptr};
+        size_t size{0};
+    };
+
+    // A pack file of compiled shaders, indexed by a 64-bit key that the caller derives from everything that affects
+    // the bytecode (source, defines, compiler). The file is memory-mapped once by open(), and entries are served from
+    // the mapping. New entries are kept in memory until flush() rewrites the file.
+    class ShaderCache {
+      public:
+        ShaderCache() = default;
+        ShaderCache(const ShaderCache&) = delete;
+        ShaderCache& operator=(const ShaderCache&) = delete;
+
+        // A missing or invalid file is not an error, the cache then starts empty.
+        void open(const std::filesystem::path& path);
+
+        // Returns an empty blob when the key is not in the cache.
+        Blob find(uint64_t key) const;
+
+        void store(uint64_t key, const void* data, size_t size);
+
+        // Write all entries (mapped and pending) to the pack file. Returns false if the file could not be written.
+        bool flush();
+
+      private:
+        void close();
+
+        std::filesystem::path m_path;
+        wil::unique_handle m_file;
+        wil::unique_handle m_mapping;
+        wil::unique_mapview_ptr<void> m_view;
+        size_t m_viewSize{0};
+
+        // Entries point either into the mapping or into m_pending.
+        std::unordered_map<uint64_t, Blob> m_index;
+        std::unordered_map<uint64_t, std::vector<uint8_t>> m_pending;
+    };
+
+} // namespace openxr_api_layer::utils::shadercache
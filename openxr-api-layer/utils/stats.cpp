@@ -0,0 +1,193 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "stats.h"
+
+#include "log.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace openxr_api_layer::utils::stats {
+
+    using namespace openxr_api_layer::log;
+
+    std::string getSharedMemoryName(uint32_t processId) {
+#ifdef _WIN32
+        return fmt::format("Local\\XR_APILAYER_OPENXR_SHARPENER_stats_{}", processId);
+#else
+        return fmt::format("/XR_APILAYER_OPENXR_SHARPENER_stats_{}", processId);
+#endif
+    }
+
+    StatsWriter::~StatsWriter() {
+        close();
+    }
+
+    bool StatsWriter::open() {
+        close();
+#ifdef _WIN32
+        const std::string name = getSharedMemoryName(GetCurrentProcessId());
+        m_mapping.reset(CreateFileMappingA(
+            INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(SharedBlock), name.c_str()));
+        if (!m_mapping) {
+            ErrorLog(fmt::format("Failed to create stats shared memory: {}\n", GetLastError()));
+            return false;
+        }
+        m_block =
+            reinterpret_cast<SharedBlock*>(MapViewOfFile(m_mapping.get(), FILE_MAP_WRITE, 0, 0, sizeof(SharedBlock)));
+        if (!m_block) {
+            m_mapping.reset();
+            return false;
+        }
+#else
+        m_name = getSharedMemoryName((uint32_t)getpid());
+        const int fd = shm_open(m_name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        void* view = MAP_FAILED;
+        if (ftruncate(fd, sizeof(SharedBlock)) == 0) {
+            view = mmap(nullptr, sizeof(SharedBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            shm_unlink(m_name.c_str());
+            return false;
+        }
+        m_block = reinterpret_cast<SharedBlock*>(view);
+#endif
+
+        // Readers check the header last, once the block is fully initialized.
+        m_block->sequence.store(0, std::memory_order_relaxed);
+        m_block->stats = {};
+        m_block->size = sizeof(SharedBlock);
+        m_block->version = StatsVersion;
+        std::atomic_thread_fence(std::memory_order_release);
+        m_block->magic = StatsMagic;
+        return true;
+    }
+
+    void StatsWriter::close() {
+        if (!m_block) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(m_block);
+        m_mapping.reset();
+#else
+        munmap(m_block, sizeof(SharedBlock));
+        shm_unlink(m_name.c_str());
+#endif
+        m_block = nullptr;
+    }
+
+    void StatsWriter::publish(const FrameStats& stats) {
+        if (!m_block) {
+            return;
+        }
+        const uint32_t sequence = m_block->sequence.load(std::memory_order_relaxed);
+        m_block->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&m_block->stats, &stats, sizeof(stats));
+        m_block->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    StatsReader::~StatsReader() {
+        close();
+    }
+
+    bool StatsReader::open(uint32_t processId) {
+        close();
+        const std::string name = getSharedMemoryName(processId);
+#ifdef _WIN32
+        m_mapping.reset(OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str()));
+        if (!m_mapping) {
+            return false;
+        }
+        m_block = reinterpret_cast<const SharedBlock*>(
+            MapViewOfFile(m_mapping.get(), FILE_MAP_READ, 0, 0, sizeof(SharedBlock)));
+        if (!m_block) {
+            m_mapping.reset();
+            return false;
+        }
+#else
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return false;
+        }
+        void* view = mmap(nullptr, sizeof(SharedBlock), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+        m_block = reinterpret_cast<const SharedBlock*>(view);
+#endif
+        if (m_block->magic != StatsMagic || m_block->version != StatsVersion || m_block->size != sizeof(SharedBlock)) {
+            close();
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    void StatsReader::close() {
+        if (!m_block) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(m_block);
+        m_mapping.reset();
+#else
+        munmap(const_cast<SharedBlock*>(m_block), sizeof(SharedBlock));
+#endif
+        m_block = nullptr;
+    }
+
+    std::optional<FrameStats> StatsReader::read() const {
+        if (!m_block) {
+            return {};
+        }
+        for (int attempt = 0; attempt < 64; attempt++) {
+            const uint32_t before = m_block->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            FrameStats stats;
+            memcpy(&stats, &m_block->stats, sizeof(stats));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_block->sequence.load(std::memory_order_relaxed) == before) {
+                return stats;
+            }
+        }
+        return {};
+    }
+
+} // namespace openxr_api_layer::utils::stats
@@ -0,0 +1,122 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::stats {
+
+    // Statistics of the current session, published in a named shared memory block so that an external tool can poll
+    // them without going through the render thread. The layout is fixed: only bump StatsVersion when it changes.
+
+    constexpr uint32_t StatsMagic = 0x53415843; // 'CXAS'
+    constexpr uint32_t StatsVersion = 1;
+
+    enum class SkipReason : uint32_t {
+        // No projection layer, or no image released for its swapchains.
+        NoImage = 0,
+        // The shaders are still being built.
+        NotReady,
+        // A pass failed for at least one view.
+        Failed,
+        Count
+    };
+
+    enum class GpuStage : uint32_t { Cas = 0, FakeHdr, Levels, Count };
+
+    struct FrameStats {
+        uint64_t sessionId;
+        uint64_t framesProcessed;
+        uint64_t framesSkipped[(uint32_t)SkipReason::Count];
+
+        // CPU time spent by the layer in xrEndFrame.
+        uint64_t endFrameCpuUsTotal;
+        uint32_t endFrameCpuUsLast;
+        float endFrameCpuUsAverage;
+
+        // GPU time of each pass, averaged over the recent frames. Zero for passes that are disabled.
+        float gpuMs[(uint32_t)GpuStage::Count];
+        uint32_t reserved0;
+
+        // Video memory held by the temporary textures.
+        uint64_t poolBytes;
+
+        // Incremented every time the configuration file is reloaded.
+        uint32_t configGeneration;
+        uint32_t reserved1;
+    };
+
+    struct SharedBlock {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;
+
+        // Seqlock: odd while the writer updates stats, a reader retries until it sees the same even value before and
+        // after its copy.
+        std::atomic<uint32_t> sequence;
+
+        FrameStats stats;
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+    // Name of the shared memory block of a process.
+    std::string getSharedMemoryName(uint32_t processId);
+
+    class StatsWriter {
+      public:
+        ~StatsWriter();
+
+        bool open();
+        void close();
+
+        // Publish a new snapshot. Never blocks.
+        void publish(const FrameStats& stats);
+
+      private:
+        SharedBlock* m_block{nullptr};
+#ifdef _WIN32
+        wil::unique_handle m_mapping;
+#else
+        std::string m_name;
+#endif
+    };
+
+    class StatsReader {
+      public:
+        ~StatsReader();
+
+        bool open(uint32_t processId);
+        void close();
+
+        // A consistent snapshot, or nothing if the writer kept updating it during all the attempts.
+        std::optional<FrameStats> read() const;
+
+      private:
+        const SharedBlock* m_block{nullptr};
+#ifdef _WIN32
+        wil::unique_handle m_mapping;
+#endif
+    };
+
+} // namespace openxr_api_layer::utils::stats
@@ -0,0 +1,101 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "telemetry.h"
+
+#include "log.h"
+
+namespace openxr_api_layer::utils::telemetry {
+
+    using namespace openxr_api_layer::log;
+
+    std::atomic<uint64_t> g_counters[(uint32_t)Event::Count]{};
+
+    namespace {
+
+        std::mutex g_dumpMutex;
+        std::chrono::steady_clock::time_point g_lastDump = std::chrono::steady_clock::now();
+        uint64_t g_lastDumpCounts[(uint32_t)Event::Count]{};
+
+    } // namespace
+
+    const char* getEventName(Event event) {
+        static const char* const names[] = {
+            "view_processed",
+            "not_ready",
+            "no_projection_layer",
+            "layer_ignored",
+            "no_released_image",
+            "image_index_out_of_range",
+            "null_texture",
+            "unsupported_format",
+            "no_store_plan",
+            "shader_pending",
+            "shader_failed",
+            "scaling_unsupported",
+            "view_creation_failed",
+            "no_output_image",
+            "pool_hit",
+            "pool_allocation",
+            "pool_eviction",
+            "pool_exhausted",
+            "composition_frame",
+            "fence_signal",
+            "fence_wait",
+            "fence_elided",
+        };
+        static_assert(std::size(names) == (size_t)Event::Count);
+        return (uint32_t)event < (uint32_t)Event::Count ? names[(uint32_t)event] : "unknown";
+    }
+
+    uint64_t getCount(Event event) {
+        return g_counters[(uint32_t)event].load(std::memory_order_relaxed);
+    }
+
+    void dumpIfDue(std::chrono::steady_clock::duration interval, bool force) {
+        const auto now = std::chrono::steady_clock::now();
+        std::unique_lock lock(g_dumpMutex);
+        if (!force && now - g_lastDump < interval) {
+            return;
+        }
+        const double seconds = std::chrono::duration<double>(now - g_lastDump).count();
+        g_lastDump = now;
+
+        std::string summary;
+        for (uint32_t i = 0; i < (uint32_t)Event::Count; i++) {
+            const uint64_t count = g_counters[i].load(std::memory_order_relaxed);
+            if (count != g_lastDumpCounts[i]) {
+                summary += fmt::format(" {}={}", getEventName((Event)i), count - g_lastDumpCounts[i]);
+                g_lastDumpCounts[i] = count;
+            }
+        }
+        if (!summary.empty()) {
+            Log(fmt::format("Events over the last {:.0f}s:{}\n", seconds, summary));
+        }
+    }
+
+} // namespace openxr_api_layer::utils::telemetry
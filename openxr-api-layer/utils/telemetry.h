@@ -0,0 +1,76 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::telemetry {
+
+    // Per-frame outcomes, counted instead of being logged one by one. The counts are summarized in the log
+    // periodically, see dumpIfDue().
+    enum class Event : uint32_t {
+        ViewProcessed = 0,
+        NotReady,
+        NoProjectionLayer,
+        LayerIgnored,
+        NoReleasedImage,
+        ImageIndexOutOfRange,
+        NullTexture,
+        UnsupportedFormat,
+        NoStorePlan,
+        ShaderPending,
+        ShaderFailed,
+        ScalingUnsupported,
+        ViewCreationFailed,
+        // No image of an output swapchain was available, the application swapchain was submitted instead.
+        NoOutputImage,
+        // Temporary texture pool: an entry reused, an entry created, an entry evicted, or no entry under the cap.
+        PoolHit,
+        PoolAllocation,
+        PoolEviction,
+        PoolExhausted,
+        // Composition fence timeline: a frame serialized, a fence signaled, a wait queued on a device, or a
+        // synchronization skipped because the other device had no pending work.
+        CompositionFrame,
+        FenceSignal,
+        FenceWait,
+        FenceElided,
+        Count
+    };
+
+    const char* getEventName(Event event);
+
+    extern std::atomic<uint64_t> g_counters[(uint32_t)Event::Count];
+
+    // Cheap enough for the hot path: a relaxed atomic increment, no formatting.
+    inline void increment(Event event) {
+        g_counters[(uint32_t)event].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t getCount(Event event);
+
+    // Log the events counted since the previous summary, if interval has elapsed (or unconditionally if force is set).
+    void dumpIfDue(std::chrono::steady_clock::duration interval, bool force = false);
+
+} // namespace openxr_api_layer::utils::telemetry
@@ -0,0 +1,130 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "texturepool.h"
+
+namespace openxr_api_layer::utils::texturepool {
+
+    Key makeKey(uint32_t width, uint32_t height, uint32_t format, uint32_t granularity) {
+        const auto roundUp = [&](uint32_t value) { return (value + granularity - 1) / granularity * granularity; };
+        return {roundUp(width), roundUp(height), format};
+    }
+
+    void Allocator::setLimits(uint64_t budgetBytes, uint64_t capBytes) {
+        m_budgetBytes = budgetBytes;
+        m_capBytes = std::max(capBytes, budgetBytes);
+    }
+
+    void Allocator::beginFrame() {
+        m_frame++;
+        while (m_stats.bytes > m_budgetBytes && evictLeastRecentlyUsed(HoldFrames)) {
+        }
+    }
+
+    std::optional<uint32_t> Allocator::acquire(const Key& key, uint64_t bytes, bool& created) {
+        created = false;
+        for (uint32_t id = 0; id < m_entries.size(); id++) {
+            Entry& entry = m_entries[id];
+            if (entry.alive && !entry.inUse && entry.key == key) {
+                entry.inUse = true;
+                entry.lastUsed = m_frame;
+                m_stats.inUse++;
+                return id;
+            }
+        }
+
+        while (m_stats.bytes + bytes > m_capBytes && evictLeastRecentlyUsed(0)) {
+        }
+        if (m_stats.bytes + bytes > m_capBytes) {
+            return std::nullopt;
+        }
+        uint32_t id;
+        if (!m_freeIds.empty()) {
+            id = m_freeIds.back();
+            m_freeIds.pop_back();
+        } else {
+            id = (uint32_t)m_entries.size();
+            m_entries.emplace_back();
+        }
+        m_entries[id] = {key, bytes, m_frame, true, true};
+        m_stats.bytes += bytes;
+        m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.bytes);
+        m_stats.entries++;
+        m_stats.inUse++;
+        created = true;
+        return id;
+    }
+
+    void Allocator::release(uint32_t id) {
+        Entry& entry = m_entries[id];
+        if (entry.alive && entry.inUse) {
+            entry.inUse = false;
+            m_stats.inUse--;
+        }
+    }
+
+    void Allocator::discard(uint32_t id) {
+        release(id);
+        if (m_entries[id].alive) {
+            remove(id);
+        }
+    }
+
+    void Allocator::clear() {
+        m_entries.clear();
+        m_freeIds.clear();
+        m_evicted.clear();
+        m_stats.bytes = 0;
+        m_stats.entries = m_stats.inUse = 0;
+    }
+
+    bool Allocator::evictLeastRecentlyUsed(uint64_t minIdleFrames) {
+        int32_t oldest = -1;
+        for (uint32_t id = 0; id < m_entries.size(); id++) {
+            const Entry& entry = m_entries[id];
+            if (entry.alive && !entry.inUse && m_frame - entry.lastUsed >= minIdleFrames &&
+                (oldest < 0 || entry.lastUsed < m_entries[oldest].lastUsed)) {
+                oldest = (int32_t)id;
+            }
+        }
+        if (oldest < 0) {
+            return false;
+        }
+        remove(oldest);
+        m_evicted.push_back(oldest);
+        return true;
+    }
+
+    void Allocator::remove(uint32_t id) {
+        Entry& entry = m_entries[id];
+        entry.alive = false;
+        m_stats.bytes -= entry.bytes;
+        m_stats.entries--;
+        m_freeIds.push_back(id);
+    }
+
+} // namespace openxr_api_layer::utils::texturepool
@@ -0,0 +1,172 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::texturepool {
+
+    // Sizes are rounded up to a multiple of this, so that swapchains and views of nearly the same size share textures.
+    constexpr uint32_t BucketGranularity = 128;
+
+    // What a pool entry can be used for: textures of at least the requested size, in a resource (typeless) format.
+    struct Key {
+        uint32_t width{0};
+        uint32_t height{0};
+        uint32_t format{0};
+
+        bool operator==(const Key& other) const {
+            return width == other.width && height == other.height && format == other.format;
+        }
+    };
+
+    // A granularity of 1 keeps the exact size, for uses that need it (eg: the target of a multisample resolve).
+    Key makeKey(uint32_t width, uint32_t height, uint32_t format, uint32_t granularity = BucketGranularity);
+
+    struct Stats {
+        uint64_t bytes{0};
+        uint64_t peakBytes{0};
+        uint32_t entries{0};
+        uint32_t inUse{0};
+    };
+
+    // The allocation policy of a pool, which only deals with entry ids so that it can run without a graphics device.
+    // An entry is acquired for the duration of a dispatch and released right after: the passes of a session run in
+    // order on one context or queue, so the next view may reuse it within the same frame. Entries are evicted least
+    // recently used first, when the pool goes over its budget at the start of a frame (only entries idle for a few
+    // frames, so that the GPU is done with them), or when a new entry would go over the cap.
+    class Allocator {
+      public:
+        static constexpr uint64_t HoldFrames = 3;
+
+        void setLimits(uint64_t budgetBytes, uint64_t capBytes);
+
+        // Advance the frame clock and trim the pool to its budget.
+        void beginFrame();
+
+        // Returns an idle entry with the key, or a new entry (created is set) if there is none. Returns nullopt if a
+        // new entry would exceed the cap even after evicting all idle entries.
+        std::optional<uint32_t> acquire(const Key& key, uint64_t bytes, bool& created);
+        void release(uint32_t id);
+
+        // Remove an acquired entry, eg: when its textures could not be created.
+        void discard(uint32_t id);
+
+        void clear();
+
+        // The entries evicted since the last call, whose textures should be released.
+        std::vector<uint32_t>& getEvicted() {
+            return m_evicted;
+        }
+
+        const Stats& getStats() const {
+            return m_stats;
+        }
+
+      private:
+        struct Entry {
+            Key key;
+            uint64_t bytes;
+            uint64_t lastUsed;
+            bool alive;
+            bool inUse;
+        };
+
+        bool evictLeastRecentlyUsed(uint64_t minIdleFrames);
+        void remove(uint32_t id);
+
+        std::vector<Entry> m_entries;
+        std::vector<uint32_t> m_freeIds;
+        std::vector<uint32_t> m_evicted;
+        uint64_t m_frame{0};
+        uint64_t m_budgetBytes{~0ull};
+        uint64_t m_capBytes{~0ull};
+        Stats m_stats;
+    };
+
+    // A pool of temporary textures shared by all the swapchains and views of a device. Textures is the API-specific
+    // set of textures of an entry, created by the caller when acquire() returns a new entry.
+    template <typename Textures>
+    class Pool {
+      public:
+        void setLimits(uint64_t budgetBytes, uint64_t capBytes) {
+            m_allocator.setLimits(budgetBytes, capBytes);
+        }
+
+        // Returns the number of entries evicted.
+        uint32_t beginFrame() {
+            m_allocator.beginFrame();
+            return releaseEvicted();
+        }
+
+        // See Allocator::acquire(). The entry stays valid until release() or discard().
+        Textures* acquire(const Key& key, uint64_t bytes, uint32_t& id, bool& created) {
+            const auto entry = m_allocator.acquire(key, bytes, created);
+            releaseEvicted();
+            if (!entry) {
+                return nullptr;
+            }
+            id = *entry;
+            if (id >= m_textures.size()) {
+                m_textures.resize(id + 1);
+            }
+            return &m_textures[id];
+        }
+
+        void release(uint32_t id) {
+            m_allocator.release(id);
+        }
+
+        void discard(uint32_t id) {
+            m_allocator.discard(id);
+            m_textures[id] = {};
+        }
+
+        void clear() {
+            m_allocator.clear();
+            m_textures.clear();
+        }
+
+        const Stats& getStats() const {
+            return m_allocator.getStats();
+        }
+
+      private:
+        uint32_t releaseEvicted() {
+            auto& evicted = m_allocator.getEvicted();
+            const uint32_t count = (uint32_t)evicted.size();
+            for (const uint32_t id : evicted) {
+                m_textures[id] = {};
+            }
+            evicted.clear();
+            return count;
+        }
+
+        Allocator m_allocator;
+
+        // Growing a deque keeps the entries in place, so that several entries can be acquired at once.
+        std::deque<Textures> m_textures;
+    };
+
+} // namespace openxr_api_layer::utils::texturepool
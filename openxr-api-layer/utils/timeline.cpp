@@ -0,0 +1,114 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "timeline.h"
+#include "telemetry.h"
+
+namespace openxr_api_layer::utils::timeline {
+
+    FenceTimeline::FenceTimeline(std::shared_ptr<IFence> applicationFence,
+                                 std::shared_ptr<IFence> applicationFenceOnCompositionDevice,
+                                 std::shared_ptr<IFence> compositionFence,
+                                 std::shared_ptr<IFence> compositionFenceOnApplicationDevice) {
+        m_applicationToComposition.signalFence = applicationFence;
+        m_applicationToComposition.waitFence = applicationFenceOnCompositionDevice;
+        m_compositionToApplication.signalFence = compositionFence;
+        m_compositionToApplication.waitFence = compositionFenceOnApplicationDevice;
+    }
+
+    FenceTimeline::~FenceTimeline() {
+        waitOnCpu();
+    }
+
+    void FenceTimeline::markApplicationWork() {
+        m_applicationToComposition.pending.store(true, std::memory_order_release);
+    }
+
+    void FenceTimeline::markCompositionWork() {
+        m_compositionToApplication.pending.store(true, std::memory_order_release);
+    }
+
+    void FenceTimeline::waitForApplication() {
+        std::unique_lock lock(m_mutex);
+        serialize(m_applicationToComposition);
+    }
+
+    void FenceTimeline::waitForComposition() {
+        std::unique_lock lock(m_mutex);
+        serialize(m_compositionToApplication);
+    }
+
+    uint64_t FenceTimeline::fenceAll() {
+        std::unique_lock lock(m_mutex);
+
+        // Once the composition device waited for the application's work, its own fence covers both devices.
+        if (serialize(m_applicationToComposition)) {
+            m_compositionToApplication.pending.store(true, std::memory_order_release);
+        }
+        flush(m_compositionToApplication);
+        return m_compositionToApplication.signaledValue;
+    }
+
+    void FenceTimeline::waitOnCpu() {
+        std::unique_lock lock(m_mutex);
+        waitOnCpu(m_compositionToApplication.signaledValue);
+        if (m_applicationToComposition.signaledValue) {
+            m_applicationToComposition.signalFence->waitOnCpu(m_applicationToComposition.signaledValue);
+        }
+    }
+
+    void FenceTimeline::waitOnCpu(uint64_t value) {
+        if (value) {
+            m_compositionToApplication.signalFence->waitOnCpu(value);
+        }
+    }
+
+    void FenceTimeline::flush(Direction& direction) {
+        // Work marked after this point is either covered by this signal or left pending for the next one.
+        if (!direction.pending.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+
+        direction.signaledValue++;
+        direction.signalFence->signal(direction.signaledValue);
+        telemetry::increment(telemetry::Event::FenceSignal);
+    }
+
+    bool FenceTimeline::serialize(Direction& direction) {
+        flush(direction);
+        if (direction.waitedValue == direction.signaledValue) {
+            telemetry::increment(telemetry::Event::FenceElided);
+            return false;
+        }
+
+        direction.waitFence->waitOnDevice(direction.signaledValue);
+        direction.waitedValue = direction.signaledValue;
+        telemetry::increment(telemetry::Event::FenceWait);
+        return true;
+    }
+
+} // namespace openxr_api_layer::utils::timeline
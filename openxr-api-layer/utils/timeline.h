@@ -0,0 +1,166 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace openxr_api_layer::utils::timeline {
+
+    // The operations of a fence that a FenceTimeline needs, on the device that opened it.
+    struct IFence {
+        virtual ~IFence() = default;
+
+        virtual void signal(uint64_t value) = 0;
+        virtual void waitOnDevice(uint64_t value) = 0;
+        virtual void waitOnCpu(uint64_t value) = 0;
+    };
+
+    // A bounded single-producer/single-consumer FIFO, to track the images of a swapchain without locks nor allocations
+    // once created. OpenXR requires the calls on a swapchain to be externally synchronized, so each end is only ever
+    // used by one thread at a time.
+    // Each end owns a cache line with its index and the last value it read of the other end's index, so that the two
+    // threads only share a line when the ring looks full to the producer or empty to the consumer.
+    template <typename T>
+    class IndexRing {
+      public:
+        void resize(uint32_t capacity) {
+            uint32_t size = 1;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            m_slots.resize(size);
+            m_mask = size - 1;
+            m_head.store(0, std::memory_order_relaxed);
+            m_tail.store(0, std::memory_order_relaxed);
+            m_cachedHead = 0;
+            m_cachedTail = 0;
+        }
+
+        bool push(const T& value) {
+            const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cachedHead > m_mask) {
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+                if (tail - m_cachedHead > m_mask) {
+                    return false;
+                }
+            }
+            m_slots[tail & m_mask] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        std::optional<T> pop() {
+            const uint32_t head = m_head.load(std::memory_order_relaxed);
+            if (!isAvailable(head)) {
+                return {};
+            }
+            const T value = m_slots[head & m_mask];
+            m_head.store(head + 1, std::memory_order_release);
+            return value;
+        }
+
+        const T* front() const {
+            const uint32_t head = m_head.load(std::memory_order_relaxed);
+            return isAvailable(head) ? &m_slots[head & m_mask] : nullptr;
+        }
+
+      private:
+        static constexpr size_t CacheLineSize = 64;
+
+        // Consumer side: whether the slot at head was pushed.
+        bool isAvailable(uint32_t head) const {
+            if (head == m_cachedTail) {
+                m_cachedTail = m_tail.load(std::memory_order_acquire);
+            }
+            return head != m_cachedTail;
+        }
+
+        std::vector<T> m_slots;
+        uint32_t m_mask{0};
+
+        // Written by the consumer.
+        alignas(CacheLineSize) std::atomic<uint32_t> m_head{0};
+        mutable uint32_t m_cachedTail{0};
+
+        // Written by the producer.
+        alignas(CacheLineSize) std::atomic<uint32_t> m_tail{0};
+        uint32_t m_cachedHead{0};
+    };
+
+    // The fences shared between the application and the composition device by a composition framework and all of its
+    // swapchains. Rather than signaling and waiting at every step, each side records that it may have pending work,
+    // and the other side only waits when it is about to touch a resource that the pending work could affect. This
+    // coalesces the synchronization of all the swapchains into (at most) one signal per direction per frame, and no
+    // wait at all on the application device for frames without composition work.
+    // Each direction has its own fence, only ever signaled from the queue of the device producing the work. Signals
+    // from two queues on one fence are not ordered against each other, and its completed value could go backwards.
+    class FenceTimeline {
+      public:
+        // Each fence, opened on both devices.
+        FenceTimeline(std::shared_ptr<IFence> applicationFence,
+                      std::shared_ptr<IFence> applicationFenceOnCompositionDevice,
+                      std::shared_ptr<IFence> compositionFence,
+                      std::shared_ptr<IFence> compositionFenceOnApplicationDevice);
+
+        ~FenceTimeline();
+
+        // The application device (or the runtime on its behalf) submitted work the composition device might consume.
+        void markApplicationWork();
+
+        // The composition device might submit work that the application device must observe.
+        void markCompositionWork();
+
+        // Serialize the pending operations on the application device before accessing from the composition device.
+        void waitForApplication();
+
+        // Serialize the pending operations on the composition device before accessing from the application device.
+        void waitForComposition();
+
+        // Fence the operations submitted so far on both devices, eg: before recycling a resource. Returns the value to
+        // wait for with waitOnCpu(). Only signals when there is work that is not fenced yet.
+        uint64_t fenceAll();
+
+        void waitOnCpu();
+        void waitOnCpu(uint64_t value);
+
+      private:
+        struct Direction {
+            std::shared_ptr<IFence> signalFence;
+            std::shared_ptr<IFence> waitFence;
+            // Set without the lock, so that acquiring an image never blocks on another thread's serialization.
+            std::atomic<bool> pending{false};
+            uint64_t signaledValue{0};
+            uint64_t waitedValue{0};
+        };
+
+        void flush(Direction& direction);
+        bool serialize(Direction& direction);
+
+        // Guards the signals and waits. Marking work does not take it.
+        std::mutex m_mutex;
+        Direction m_applicationToComposition;
+        Direction m_compositionToApplication;
+    };
+
+} // namespace openxr_api_layer::utils::timeline
@@ -0,0 +1,95 @@
+// MIT License
+//
+// << insert your own copyright here >>
+//
+// Based on https://github.com/mbucchia/OpenXR-Layer-Template.
+// Copyright(c) 2022-2023 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "worker.h"
+
+#include "log.h"
+
+namespace openxr_api_layer::utils::worker {
+
+    using namespace openxr_api_layer::log;
+
+    Worker::Worker(const std::string& name) {
+        m_thread = std::thread([this, name]() {
+            const std::wstring threadName(name.begin(), name.end());
+            SetThreadDescription(GetCurrentThread(), threadName.c_str());
+            run();
+        });
+    }
+
+    Worker::~Worker() {
+        // Jobs that have not started yet are dropped.
+        {
+            std::unique_lock lock(m_mutex);
+            m_stop = true;
+            m_jobs.clear();
+        }
+        m_wakeUp.notify_one();
+        m_thread.join();
+    }
+
+    void Worker::post(std::function<void()> job) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_wakeUp.notify_one();
+    }
+
+    void Worker::drain() {
+        std::unique_lock lock(m_mutex);
+        m_idle.wait(lock, [&] { return m_jobs.empty() && !m_busy; });
+    }
+
+    void Worker::run() {
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_wakeUp.wait(lock, [&] { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                break;
+            }
+
+            auto job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_busy = true;
+            lock.unlock();
+            try {
+                job();
+            } catch (std::exception& exc) {
+                ErrorLog(fmt::format("Worker job failed: {}\n", exc.what()));
+            }
+            lock.lock();
+            m_busy = false;
+            if (m_jobs.empty()) {
+                m_idle.notify_all();
+            }
+        }
+        m_busy = false;
+        m_idle.notify_all();
+    }
+
+} // namespace openxr_api_layer::utils::worker